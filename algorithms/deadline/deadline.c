@@ -0,0 +1,110 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <time.h>
+#include <limits.h>
+
+#include "deadline.h"
+
+/* Returns the time in nanoseconds on the monotonic clock, the one of the deadlines. */
+uint64_t deadline_now() {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000) + (uint64_t)now.tv_nsec;
+
+}
+
+
+void deadline_init(deadline_clock* clock) {
+
+    clock->period = 1;
+    deadline_start(clock, 0);
+
+}
+
+
+/* Sets the deadline the next calls check, 0 for none. The first call comes before any work, so the clock is first read
+ * after period + 1 calls. */
+void deadline_start(deadline_clock* clock, uint64_t deadline) {
+
+    clock->deadline = deadline;
+    clock->lastCheck = deadline > 0 ? deadline_now() : 0;
+    clock->nbCalls = deadline > 0 ? clock->period + 1 : UINT_MAX;
+
+}
+
+
+/* Reads the clock and calibrates the period from the time the period calls since the last reading took. */
+char deadline_check(deadline_clock* clock) {
+
+    uint64_t now = 0;
+    uint64_t interval = DEADLINE_CHECK_INTERVAL;
+    uint64_t period = 0;
+
+    if(clock->deadline == 0) {
+        clock->nbCalls = UINT_MAX;
+        return 0;
+    }
+
+    now = deadline_now();
+
+    if(now >= clock->deadline) {
+        clock->nbCalls = 1;
+        return 1;
+    }
+
+    if(((clock->deadline - now) / 2) < interval)                                                // Closer readings as the deadline nears
+        interval = (clock->deadline - now) / 2;
+
+    period = now > clock->lastCheck ? (clock->period * interval) / (now - clock->lastCheck) : 2 * (uint64_t)clock->period;
+
+    if(period > (2 * (uint64_t)clock->period))                                                  // At most doubled, in case the calls were faster than usual
+        period = 2 * (uint64_t)clock->period;
+    if(period < 1)
+        period = 1;
+    if(period > DEADLINE_MAX_PERIOD)
+        period = DEADLINE_MAX_PERIOD;
+
+    clock->period = (unsigned int)period;
+    clock->lastCheck = now;
+    clock->nbCalls = clock->period;
+
+    return 0;
+
+}
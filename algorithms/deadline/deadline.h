@@ -0,0 +1,70 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <stdint.h>
+
+#define DEADLINE_CHECK_INTERVAL 20000   // Time in nanoseconds the clock is read about every, far from the deadline
+#define DEADLINE_MAX_PERIOD 1048576
+
+/* Checks of a deadline which only read the clock every period calls. The period is calibrated at each reading from
+ * the time the last calls took, so that the clock is read about every DEADLINE_CHECK_INTERVAL nanoseconds, and at least
+ * twice in the time left. It is kept from one deadline to the next. */
+typedef struct {
+        uint64_t deadline;                  // In nanoseconds on the clock of deadline_now. 0 if there is none
+        uint64_t lastCheck;                 // When the clock was last read
+        unsigned int period;                // Number of calls between two readings of the clock
+        unsigned int nbCalls;               // Number of calls left before the next reading
+}   deadline_clock;
+
+uint64_t deadline_now();
+void deadline_init(deadline_clock* clock);
+void deadline_start(deadline_clock* clock, uint64_t deadline);
+char deadline_check(deadline_clock* clock);
+
+/* Returns 1 if the deadline is over, 0 else or if there is no deadline. */
+static inline char deadline_isOver(deadline_clock* clock) {
+
+    if(clock->nbCalls > 1) {
+        clock->nbCalls--;
+        return 0;
+    }
+
+    return deadline_check(clock);
+
+}
+
+#endif
@@ -0,0 +1,158 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "discount.h"
+
+#define INITIAL_NB_DEPTHS 64
+
+static discount_table* tables = NULL;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;          // Taken to go through the list of tables or to grow one
+
+
+/* Returns arrays covering nbDepths depths, the first ones copied from old if it is not NULL. The depths are added one by
+ * one from the last one, so that a power is the same whenever the table was grown. */
+static discount_values* makeValues(double gamma, discount_values* old, unsigned int nbDepths) {
+
+    discount_values* values = (discount_values*)malloc(sizeof(discount_values));
+    unsigned int i = 1;
+
+    values->nbDepths = nbDepths;
+    values->powers = (double*)malloc(sizeof(double) * nbDepths);
+    values->bounds = (double*)malloc(sizeof(double) * nbDepths);
+    values->previous = old;
+
+    if(old != NULL) {
+        memcpy(values->powers, old->powers, sizeof(double) * old->nbDepths);
+        memcpy(values->bounds, old->bounds, sizeof(double) * old->nbDepths);
+        i = old->nbDepths;
+    } else {
+        values->powers[0] = 1.0;
+        values->bounds[0] = 1.0 / (1.0 - gamma);
+    }
+
+    for(; i < nbDepths; i++) {
+        values->powers[i] = values->powers[i - 1] * gamma;
+        values->bounds[i] = values->powers[i] / (1.0 - gamma);
+    }
+
+    return values;
+
+}
+
+
+/* Returns the table of gamma, made if no instance uses it yet. To release with discount_releaseTable. */
+discount_table* discount_getTable(double gamma) {
+
+    discount_table* table = NULL;
+
+    pthread_mutex_lock(&mutex);
+
+    for(table = tables; (table != NULL) && (table->gamma != gamma); table = table->next);
+
+    if(table == NULL) {
+        table = (discount_table*)malloc(sizeof(discount_table));
+        table->gamma = gamma;
+        table->values = makeValues(gamma, NULL, INITIAL_NB_DEPTHS);
+        table->nbUsers = 0;
+        table->next = tables;
+        tables = table;
+    }
+
+    table->nbUsers++;
+
+    pthread_mutex_unlock(&mutex);
+
+    return table;
+
+}
+
+
+/* Makes the table cover at least nbDepths depths, twice as many as before if it is more, and returns its arrays. */
+discount_values* discount_grow(discount_table* table, unsigned int nbDepths) {
+
+    discount_values* values = NULL;
+
+    pthread_mutex_lock(&mutex);
+
+    if(table->values->nbDepths < nbDepths) {
+        if(nbDepths < (2 * table->values->nbDepths))
+            nbDepths = 2 * table->values->nbDepths;
+
+        __atomic_store_n(&table->values, makeValues(table->gamma, table->values, nbDepths), __ATOMIC_RELEASE);
+    }
+
+    values = table->values;
+
+    pthread_mutex_unlock(&mutex);
+
+    return values;
+
+}
+
+
+/* The table is freed once no instance uses it anymore. */
+void discount_releaseTable(discount_table** table) {
+
+    pthread_mutex_lock(&mutex);
+
+    if(--(*table)->nbUsers == 0) {
+        discount_table** crt = &tables;
+        discount_values* values = (*table)->values;
+
+        while(*crt != *table)
+            crt = &(*crt)->next;
+        *crt = (*table)->next;
+
+        while(values != NULL) {
+            discount_values* previous = values->previous;
+            free(values->powers);
+            free(values->bounds);
+            free(values);
+            values = previous;
+        }
+
+        free(*table);
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    *table = NULL;
+
+}
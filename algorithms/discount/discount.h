@@ -0,0 +1,85 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef DISCOUNT_H
+#define DISCOUNT_H
+
+/* Powers of gamma and the bounds they give, for the depths reached so far. The arrays are never changed once written:
+ * to cover deeper depths, longer ones are made and published in their place, and the old ones are only freed with the
+ * table. So an array read by a thread stays valid while another thread grows the table. */
+typedef struct discount_values_struct {
+        unsigned int nbDepths;                      // Number of depths the arrays cover
+        double* powers;                             // gamma to the power of each depth
+        double* bounds;                             // gamma^depth / (1 - gamma): the most the rewards from a depth on can add to a discounted sum
+        struct discount_values_struct* previous;    // The arrays these ones replaced
+}   discount_values;
+
+/* One table per discount factor, shared by every instance using it. */
+typedef struct discount_table_struct {
+        double gamma;
+        discount_values* values;                    // The arrays covering the most depths
+        unsigned int nbUsers;
+        struct discount_table_struct* next;         // Next table of the list of every table
+}   discount_table;
+
+discount_table* discount_getTable(double gamma);
+discount_values* discount_grow(discount_table* table, unsigned int nbDepths);
+void discount_releaseTable(discount_table** table);
+
+/* Returns gamma to the power of the depths 0 to nbDepths - 1 at least. The array stays valid until the table is released. */
+static inline const double* discount_getPowers(discount_table* table, unsigned int nbDepths) {
+
+    discount_values* values = __atomic_load_n(&table->values, __ATOMIC_ACQUIRE);
+
+    if(values->nbDepths < nbDepths)
+        values = discount_grow(table, nbDepths);
+
+    return values->powers;
+
+}
+
+
+/* Same as discount_getPowers for the bounds. */
+static inline const double* discount_getBounds(discount_table* table, unsigned int nbDepths) {
+
+    discount_values* values = __atomic_load_n(&table->values, __ATOMIC_ACQUIRE);
+
+    if(values->nbDepths < nbDepths)
+        values = discount_grow(table, nbDepths);
+
+    return values->bounds;
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+/* Compiles the kernel file KERNEL_FILE once per branching factor the planners are specialized for, then once for any
+ * other one. A kernel file holds the static functions looping over the K children of a node: KERNEL_K is the branching
+ * factor they are compiled for, a constant the compiler can unroll the loops with, or K for the generic ones, and
+ * KERNEL(name) the name of a function for this branching factor. KERNEL_SELECT(name) returns the address of the one
+ * compiled for the current K.
+ *
+ * Not guarded: a planner includes it once, after defining KERNEL_FILE as the path of its kernel file from this
+ * directory. */
+
+#define KERNEL_K 2
+#define KERNEL(name) name##2
+#include KERNEL_FILE
+#undef KERNEL_K
+#undef KERNEL
+
+#define KERNEL_K 3
+#define KERNEL(name) name##3
+#include KERNEL_FILE
+#undef KERNEL_K
+#undef KERNEL
+
+#define KERNEL_K 4
+#define KERNEL(name) name##4
+#include KERNEL_FILE
+#undef KERNEL_K
+#undef KERNEL
+
+#define KERNEL_K 9
+#define KERNEL(name) name##9
+#include KERNEL_FILE
+#undef KERNEL_K
+#undef KERNEL
+
+#define KERNEL_K K
+#define KERNEL(name) name##Generic
+#include KERNEL_FILE
+#undef KERNEL_K
+#undef KERNEL
+
+#define KERNEL_SELECT(name) (K == 2 ? &name##2 : (K == 3 ? &name##3 : (K == 4 ? &name##4 : (K == 9 ? &name##9 : &name##Generic))))
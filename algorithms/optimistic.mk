@@ -1,25 +1,40 @@
 CC_OPTIONS := -O3
 USE_SDL := 1
 CC := gcc
-FLAGS := -W -Wall $(CC_OPTIONS) -ansi -std=c99 -pedantic -Werror$(if $(USE_SDL), -DUSE_SDL)
-LIBS := -lm$(if $(USE_SDL), -lSDL -lSDLmain /usr/lib/libSDL_gfx.so) -largtable2 -lgsl -lgslcblas
+FLAGS := -W -Wall $(CC_OPTIONS) -ansi -std=c99 -pedantic -Werror$(if $(USE_SDL), -DUSE_SDL)$(if $(USE_STATS), -DUSE_STATS)
+LIBS := -lm -lpthread$(if $(USE_SDL), -lSDL -lSDLmain /usr/lib/libSDL_gfx.so) -largtable2
 BIN_DIR := ../bin
 OBJ_DIR := ../obj
 
-all: $(addprefix $(BIN_DIR)/optimistic_,$(PROBLEMS)) $(OBJ_DIR)/optimistic_limited.o
+all: $(addprefix $(BIN_DIR)/optimistic_,$(PROBLEMS))
 
-$(OBJ_DIR)/optimistic.o: optimistic/optimistic.c optimistic/optimistic.h
+$(OBJ_DIR)/region.o: region/region.c region/region.h
 	$(CC) -c $(FLAGS) $< -o $@
 
-$(OBJ_DIR)/optimistic_limited.o: optimistic/optimistic.c optimistic/optimistic.h
-	$(CC) -c $(FLAGS) -DLIMITED_DEPTH $< -o $@
+$(OBJ_DIR)/thread_pool.o: thread_pool/thread_pool.c thread_pool/thread_pool.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/discount.o: discount/discount.c discount/discount.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/deadline.o: deadline/deadline.c deadline/deadline.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/stats.o: stats/stats.c stats/stats.h deadline/deadline.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/transposition.o: transposition/transposition.c transposition/transposition.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/optimistic.o: optimistic/optimistic.c optimistic/optimistic.h optimistic/optimistic_kernel.h kernel/kernel.h region/region.h transposition/transposition.h thread_pool/thread_pool.h discount/discount.h deadline/deadline.h stats/stats.h
+	$(CC) -c $(FLAGS) $< -o $@
 
-$(OBJ_DIR)/optimistic_drawing.o: optimistic/optimistic_drawing.c optimistic/optimistic_drawing.h optimistic/optimistic.h
+$(OBJ_DIR)/optimistic_drawing.o: optimistic/optimistic_drawing.c optimistic/optimistic_drawing.h optimistic/optimistic.h thread_pool/thread_pool.h discount/discount.h deadline/deadline.h stats/stats.h
 	$(CC) -c $(FLAGS) $< -o $@
 
 $(OBJ_DIR)/main_optimistic.o: optimistic/main_optimistic.c
 	$(CC) -c $(FLAGS) $< -o $@
 
 .SECONDEXPANSION:
-$(BIN_DIR)/optimistic_%: $(OBJ_DIR)/optimistic.o $(OBJ_DIR)/main_optimistic.o $(OBJ_DIR)/$$*.o $(if $(USE_SDL),$(OBJ_DIR)/optimistic_drawing.o) $$(if $(USE_SDL),$(OBJ_DIR)/viewer_$$*.o)
+$(BIN_DIR)/optimistic_%: $(OBJ_DIR)/optimistic.o $(OBJ_DIR)/region.o $(OBJ_DIR)/transposition.o $(OBJ_DIR)/thread_pool.o $(OBJ_DIR)/discount.o $(OBJ_DIR)/deadline.o $(OBJ_DIR)/stats.o $(OBJ_DIR)/main_optimistic.o $(OBJ_DIR)/$$*.o $(if $(USE_SDL),$(OBJ_DIR)/optimistic_drawing.o) $$(if $(USE_SDL),$(OBJ_DIR)/viewer_$$*.o)
 	$(CC) $(FLAGS) $(LIBS) $^ -o $@
@@ -34,7 +34,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 #include <unistd.h>
+#include <time.h>
 #include <argtable2.h>
 
 #include "../../problems/generative_model.h"
@@ -47,14 +50,73 @@
 #include "optimistic.h"
 
 
+/* The planning of a step, done by the main thread or, in the pipelined mode, by the planner thread while the last
+ * action is applied. */
+typedef struct {
+    optimistic_instance* instance;
+    unsigned int maxNbEvaluations;
+    unsigned int deadline;              // Time in microseconds the planning is given from its start, 0 if it has none
+    action* optimalAction;
+    FILE* statsFile;                    // Where the counters of the planning are written, NULL if they are not
+    char isCsv;
+    unsigned int step;                  // Step the planning is for
+}   planning_job;
+
+
+static void* plan(void* data) {
+
+    planning_job* job = (planning_job*)data;
+    uint64_t start = deadline_now();
+
+    if(job->deadline > 0)
+        job->optimalAction = optimistic_planningDeadline(job->instance, job->maxNbEvaluations, deadline_now() + ((uint64_t)job->deadline * 1000));
+    else
+        job->optimalAction = optimistic_planning(job->instance, job->maxNbEvaluations);
+
+    if(job->statsFile != NULL) {                                                                // What keepSubtree did before the planning is counted with it
+        stats_write(job->statsFile, job->isCsv, job->step, job->instance->realNbEvaluations, deadline_now() - start, &job->instance->stats);
+        stats_reset(&job->instance->stats);
+    }
+
+    return NULL;
+
+}
+
+
+/* Returns 1 if a and b are the same state, their padding left out, 0 else. keys has room for two keys. */
+static char isSameState(state* a, state* b, double* keys) {
+
+    unsigned int keyLength = getStateKeyLength();
+
+    getStateKey(a, 0.0, keys);
+    getStateKey(b, 0.0, keys + keyLength);
+
+    return memcmp(keys, keys + keyLength, sizeof(double) * keyLength) == 0;
+
+}
+
+
 int main(int argc, char* argv[]) {
 
     double discountFactor;
     unsigned int maxNbEvaluations;
     char isTerminal = 0;
     char keepingTree = 0;
+    char isLeafQueueUsed = 0;
+    unsigned int nbThreads = 1;
+    char isEvaluationCountKept = 0;
     int nbTimestep = -1;
     unsigned int branchingFactor = 0;
+    region_reclaimer* reclaimer = NULL;
+    size_t maxNbBytes = 0;
+    char isPruningUsed = 0;
+    transposition_table* table = NULL;
+    double quantum = 0.0;
+    unsigned int deadline = 0;
+    char isPipelined = 0;
+    FILE* statsFile = NULL;
+    char isCsv = 0;
+    unsigned int step = 0;
 
 #ifdef USE_SDL
     char isDisplayed = 1;
@@ -71,6 +133,10 @@ int main(int argc, char* argv[]) {
     state* nextState = NULL;
     double reward = 0.0;
     action* optimalAction = NULL;
+    action* plannedAction = NULL;       // In the pipelined mode, the action planned for the next step while the last one was applied
+    planning_job job;
+    pthread_t planner;
+    double* keys = NULL;
 
     struct arg_dbl* g = arg_dbl1("g", "discountFactor", "<d>", "The discount factor for the problem");
     struct arg_int* n = arg_int1("n", "nbEvaluations", "<n>", "The number of evaluations");
@@ -78,17 +144,29 @@ int main(int argc, char* argv[]) {
     struct arg_int* b = arg_int0("b", "branchingFactor", "<n>", "The branching factor of the problem");
     struct arg_lit* k = arg_lit0("k", NULL, "Keep the subtree");
     struct arg_str* i = arg_str0(NULL, "state", "<s>", "The initial state to use");
+    struct arg_lit* q = arg_lit0("q", NULL, "Take the next leaf to open from a queue of the open leaves");
+    struct arg_int* t = arg_int0("t", "threads", "<n>", "The number of threads, each opening one of the best leaves of the queue per round");
+    struct arg_lit* e = arg_lit0("e", NULL, "With several threads, do not do more evaluations than a single one");
+    struct arg_lit* c = arg_lit0("c", NULL, "Release the cutted subtrees in a background thread");
+    struct arg_int* m = arg_int0("m", "memory", "<n>", "The maximum size of the tree in megabytes");
+    struct arg_lit* p = arg_lit0("p", NULL, "Release the least promising subtrees at the maximum size of the tree instead of stopping");
+    struct arg_int* x = arg_int0("x", "transposition", "<n>", "The size in megabytes of a transposition table of the simulated states");
+    struct arg_dbl* u = arg_dbl0(NULL, "quantum", "<d>", "The step the states are quantized by in the transposition table. 0 to compare them exactly");
+    struct arg_int* w = arg_int0(NULL, "seed", "<n>", "The seed of the random numbers, the current time if not given");
+    struct arg_int* l = arg_int0(NULL, "deadline", "<n>", "The time in microseconds each step is planned for at most");
+    struct arg_lit* o = arg_lit0(NULL, "pipeline", "Plan each step from the state the last action should lead to while it is applied");
+    struct arg_str* y = arg_str0(NULL, "stats", "<s>", "The file the counters of each planning are written to, as CSV if it ends with .csv, JSON lines else. Needs a build with USE_STATS");
 
 #ifdef USE_SDL
     struct arg_lit* d = arg_lit0("d", NULL, "Display the viewer");
     struct arg_lit* f = arg_lit0("f", NULL, "Fullscreen");
     struct arg_lit* v = arg_lit0("v", NULL, "Verbose");
     struct arg_str* r = arg_str0(NULL, "resolution", "<s>", "The resolution of the display window");
-    void* argtable[11];
-    int nbArgs = 10;
+    void* argtable[23];
+    int nbArgs = 22;
 #else
-    void* argtable[7];
-    int nbArgs = 6;
+    void* argtable[19];
+    int nbArgs = 18;
 #endif
 
     struct arg_end* end = arg_end(nbArgs+1);
@@ -96,14 +174,17 @@ int main(int argc, char* argv[]) {
 
     s->ival[0] = -1;
     b->ival[0] = 0;
+    t->ival[0] = 1;
+    m->ival[0] = 0;
+    u->dval[0] = 0.0;
 
-    argtable[0] = g; argtable[1] = n; argtable[2] = s; argtable[3] = k; argtable[4] = b; argtable[5] = i;
+    argtable[0] = g; argtable[1] = n; argtable[2] = s; argtable[3] = k; argtable[4] = b; argtable[5] = i; argtable[6] = q; argtable[7] = t; argtable[8] = e; argtable[9] = c; argtable[10] = m; argtable[11] = p; argtable[12] = x; argtable[13] = u; argtable[14] = w; argtable[15] = l; argtable[16] = o; argtable[17] = y;
 
 #ifdef USE_SDL
-    argtable[6] = d;
-    argtable[7] = f;
-    argtable[8] = v;
-    argtable[9] = r;
+    argtable[18] = d;
+    argtable[19] = f;
+    argtable[20] = v;
+    argtable[21] = r;
 #endif
 
     argtable[nbArgs] = end;
@@ -124,11 +205,33 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
+    if(y->count) {
+        size_t length = strlen(y->sval[0]);
+
+        if(!STATS_ENABLED) {
+            printf("error: --stats needs a build with USE_STATS\n");
+            arg_freetable(argtable, nbArgs+1);
+            return EXIT_FAILURE;
+        }
+
+        statsFile = fopen(y->sval[0], "w");
+        if(statsFile == NULL) {
+            printf("error: can not open %s\n", y->sval[0]);
+            arg_freetable(argtable, nbArgs+1);
+            return EXIT_FAILURE;
+        }
+
+        isCsv = (length > 4) && (strcmp(y->sval[0] + length - 4, ".csv") == 0);
+        stats_writeHeader(statsFile, isCsv);
+    }
+
     discountFactor = g->dval[0];
     maxNbEvaluations = n->ival[0];
 
     branchingFactor = b->ival[0];
 
+    modelSeed = w->count ? (uint64_t)w->ival[0] : (uint64_t)time(NULL);
+
     initGenerativeModelParameters();
     if(branchingFactor)
         K = branchingFactor;
@@ -148,10 +251,35 @@ int main(int argc, char* argv[]) {
 
     nbTimestep = s->ival[0];
     keepingTree = k->count;
+    isLeafQueueUsed = q->count;
+    nbThreads = t->ival[0];
+    isEvaluationCountKept = e->count;
+    if(c->count)
+        reclaimer = region_initReclaimer();
+    maxNbBytes = (size_t)m->ival[0] * 1048576;
+    isPruningUsed = p->count;
+    quantum = u->dval[0];
+    if(x->count)
+        table = transposition_initTable((size_t)x->ival[0] * 1048576, quantum);
+    deadline = l->count ? l->ival[0] : 0;
+    isPipelined = o->count;
 
     arg_freetable(argtable, nbArgs+1);
 
     instance = optimistic_initInstance(crtState, discountFactor);
+    optimistic_setLeafQueue(instance, isLeafQueueUsed);
+    optimistic_setThreads(instance, nbThreads, isEvaluationCountKept);
+    optimistic_setMemoryLimit(instance, maxNbBytes, isPruningUsed);
+    optimistic_setReclaimer(instance, reclaimer);
+    optimistic_setTranspositionTable(instance, table);
+
+    job.instance = instance;
+    job.maxNbEvaluations = maxNbEvaluations;
+    job.deadline = deadline;
+    job.statsFile = statsFile;
+    job.isCsv = isCsv;
+    if(isPipelined)
+        keys = (double*)malloc(sizeof(double) * 2 * getStateKeyLength());
 
 #ifdef USE_SDL
     if(isDisplayed) {
@@ -162,23 +290,52 @@ int main(int argc, char* argv[]) {
 #endif
 
     do {
-        if(keepingTree)
-            optimistic_keepSubtree(instance);
-        else
-            optimistic_resetInstance(instance, crtState);
+        if(plannedAction != NULL) {                                                         // Planned while the last action was applied
+            optimalAction = plannedAction;
+        } else {
+            if(keepingTree && !isPipelined)
+                optimistic_keepSubtree(instance);
+            else
+                optimistic_resetInstance(instance, crtState);
+
+            job.step = step;
+            plan(&job);
+            optimalAction = job.optimalAction;
+        }
 
-        optimalAction = optimistic_planning(instance, maxNbEvaluations);
+        if(isPipelined) {                                                                   // The root of the kept subtree is the state the action leads to if the model is deterministic
+            optimistic_keepSubtree(instance);
+            job.step = step + 1;
+            pthread_create(&planner, NULL, plan, &job);
+        }
 
         isTerminal = nextStateReward(crtState, optimalAction, &nextState, &reward);
         freeState(crtState);
         crtState = nextState;
 
+        if(isPipelined) {                                                                   // Planned from another state than the one reached, the next step is planned again
+            pthread_join(planner, NULL);
+            plannedAction = isSameState(crtState, instance->root->s, keys) ? job.optimalAction : NULL;
+        }
+
         if(verbose) {
             printState(crtState);
             printAction(optimalAction);
             printf("reward: %f depth: %u\n", reward, optimistic_getMaxDepth(instance));
+            if(deadline > 0)
+                printf("deadline: %u evaluations\n", instance->realNbEvaluations);
+            if(isPipelined && !isTerminal && (plannedAction == NULL))
+                printf("pipeline: state mispredicted\n");
+            if(instance->nbPrunedSubtrees > 0)
+                printf("memory limit: %u subtrees released\n", instance->nbPrunedSubtrees);
+            if(instance->isMemoryFull)
+                printf("memory limit: planning stopped\n");
+            if(table != NULL)
+                printf("transposition: %lu hits out of %lu lookups\n", (unsigned long)table->nbHits, (unsigned long)table->nbLookups);
         }
 
+        step++;
+
 #ifdef USE_SDL
     } while(!isTerminal && (nbTimestep < 0 || --nbTimestep) && !viewer(crtState, optimalAction, reward, instance));
 #else
@@ -187,7 +344,14 @@ int main(int argc, char* argv[]) {
 
     freeState(crtState);
 
+    free(keys);
+    if(statsFile != NULL)
+        fclose(statsFile);
     optimistic_uninitInstance(&instance);
+    if(reclaimer != NULL)
+        region_uninitReclaimer(&reclaimer);
+    if(table != NULL)
+        transposition_uninitTable(&table);
 
     freeGenerativeModel();
     freeGenerativeModelParameters();
@@ -41,28 +41,67 @@
 #include "../../problems/generative_model.h"
 
 
-static double crtDiscountedSums[OPTIMISTIC_MAX_DEPTH];
+#define VALUES(instance, n) ((n)->father ? (n)->father->children : &(instance)->rootValues)     // Where the values of a node are
+#define INDEX(n) ((n)->father ? (n)->id : 0)
 
+#define MIN_ROOT_GAMMA_POWER 1e-3       // Below, the values are rebased on the root before they lose too much precision
+
+/* The functions looping over the children of a node, compiled for the branching factors of ../kernel/kernel.h. */
+typedef struct {
+        void (*updateMaxBound)(optimistic_children* values, unsigned int id, optimistic_node* n);
+        void (*updateAncestors)(optimistic_instance* instance, optimistic_node* n);
+}   optimistic_kernel;
+
+#define KERNEL_FILE "../optimistic/optimistic_kernel.h"
+#include "../kernel/kernel.h"
+
+static const optimistic_kernel* crtKernel = &kernelGeneric;                                 // The functions compiled for K, chosen at the initialization of an instance
 
 
 optimistic_instance* optimistic_initInstance(state* initial, double discountFactor) {
 
     optimistic_instance* instance = (optimistic_instance*)malloc(sizeof(optimistic_instance));
-    unsigned int i = 1;
+    unsigned int i = 0;
 
     memset(instance, 0xda, sizeof(optimistic_instance));
 
-    instance->gammaPowers[0] = 1.0;
-    instance->bounds[0] = 1.0 / (1.0 - discountFactor);
-
-    for(; i < OPTIMISTIC_MAX_DEPTH; i++) {
-        instance->gammaPowers[i] = instance->gammaPowers[i - 1] * discountFactor;
-        instance->bounds[i] = instance->gammaPowers[i] / (1.0 - discountFactor);
-    }
+    crtKernel = KERNEL_SELECT(kernel);
 
     instance->gamma = discountFactor;
+    instance->discount = discount_getTable(discountFactor);
+    instance->maxDepth = OPTIMISTIC_MAX_DEPTH;
+    instance->pathDiscountedSums = NULL;
+    instance->pathSize = 0;
     instance->root = NULL;
     instance->totalNbEvaluations = 0;
+    instance->isLeafQueueUsed = 0;
+    instance->leafQueue = NULL;
+    instance->threads = NULL;
+    instance->nbThreads = 1;
+    instance->isEvaluationCountKept = 0;
+    instance->opennedLeaves = NULL;
+    instance->isPruningUsed = 0;
+    instance->isMemoryFull = 0;
+    instance->nbPrunedSubtrees = 0;
+    instance->table = NULL;
+    deadline_init(&instance->clock);
+    stats_init(&instance->stats);
+
+    instance->rootValues.bounds = &instance->rootBound;
+    instance->rootValues.discountedSums = &instance->rootDiscountedSum;
+    instance->rootValues.leaves = &instance->rootLeaf;
+    instance->rootValues.isClosedBranch = &instance->rootIsClosedBranch;
+    instance->rootValues.nodes = NULL;
+
+    instance->stateSize = getStateSize();
+    instance->childrenSize = sizeof(optimistic_children) + K * (2 * sizeof(double) + sizeof(optimistic_node*) + sizeof(optimistic_node) + instance->stateSize + sizeof(char));
+
+    instance->pool = region_initPool();
+    instance->nodeRegions = (region*)malloc(sizeof(region) * (K + 1));
+
+    for(i = 0; i <= K; i++)
+        region_init(instance->nodeRegions + i, instance->pool);
+    region_init(&instance->oldNodes, instance->pool);
 
     if(initial != NULL)
         optimistic_resetInstance(instance, initial);
@@ -71,39 +110,49 @@ optimistic_instance* optimistic_initInstance(state* initial, double discountFact
 
 }
 
-static void deleteTree(optimistic_node *n) {
 
-    if(n->children == NULL) {
-        free(n->values);
+/* Lays the arrays and the states of the children out after the header of a block: the chars come last to keep the
+ * others aligned. */
+static optimistic_children* initChildren(optimistic_instance* instance, void* block) {
 
-        freeState(n->s);
+    optimistic_children* children = (optimistic_children*)block;
+    char* states = NULL;
+    unsigned int i = 0;
 
-        return;
-    }
+    children->bounds = (double*)(children + 1);
+    children->discountedSums = children->bounds + K;
+    children->leaves = (optimistic_node**)(children->discountedSums + K);
+    children->nodes = (optimistic_node*)(children->leaves + K);
+    states = (char*)(children->nodes + K);
+    children->isClosedBranch = states + (K * instance->stateSize);
 
-    optimistic_node* crt = n->children;
+    for(; i < K; i++)
+        children->nodes[i].s = (state*)(states + (i * instance->stateSize));
 
-    while(1) {
-        while(crt->children != NULL)
-            crt = crt->children;
+    return children;
 
-        freeState(crt->s);
-        free(crt->values);
+}
 
-        while((crt != n) && (crt->id >= (K - 1))) {
-            crt = crt->father;
 
-            if(crt) {
-                free(crt->children);
-                freeState(crt->s);
-            }
-        }
+/* Releases r and counts it as one free. */
+static void releaseRegion(optimistic_instance* instance, region* r) {
 
-        if(crt != n)
-            crt = crt->father->children + crt->id + 1;
-        else
-            return;
-    }
+    STATS_ADD(&instance->stats, nbFrees, region_getSize(r) > 0 ? 1 : 0);
+    region_release(r);
+
+}
+
+
+static void deleteTree(optimistic_instance* instance) {
+
+    unsigned int i = 0;
+
+    for(; i <= K; i++)
+        releaseRegion(instance, instance->nodeRegions + i);
+
+    releaseRegion(instance, &instance->oldNodes);
+
+    freeState(instance->root->s);
 
 }
 
@@ -111,7 +160,7 @@ static void deleteTree(optimistic_node *n) {
 void optimistic_resetInstance(optimistic_instance* instance, state* initial) {
 
     if(instance->root != NULL) {
-        deleteTree(instance->root);
+        deleteTree(instance);
         free(instance->root);
     }
 
@@ -123,17 +172,21 @@ void optimistic_resetInstance(optimistic_instance* instance, state* initial) {
     instance->root->children = NULL;
 
     instance->root->reward = 0.0;
+    instance->root->depth = 0;
+    instance->root->nbNodes = 0;
 
-    instance->root->values = malloc(sizeof(optimistic_node_values));
-    ((optimistic_node_values*)instance->root->values)->bound = 0.0;
-    ((optimistic_node_values*)instance->root->values)->discountedSum = 0.0;
-    ((optimistic_node_values*)instance->root->values)->depth = 0;
+    instance->rootBound = 0.0;
+    instance->rootDiscountedSum = 0.0;
+    instance->rootLeaf = instance->root;
+    instance->rootIsClosedBranch = 0;
 
     instance->root->id = K;
-    instance->root->isClosedBranch = 0;
+    instance->root->queueChild = NULL;
+    instance->root->queueSibling = NULL;
 
     instance->crtNbEvaluations = 0;
     instance->nextOpennedNode = instance->root;
+    instance->leafQueue = instance->root;
     instance->crtOptimalAction = 0;
     instance->crtOptimalValue = 0.0;
     instance->root->trajectoryId = 0;
@@ -142,101 +195,405 @@ void optimistic_resetInstance(optimistic_instance* instance, state* initial) {
 }
 
 
-static void buildingTrajectory(optimistic_instance* instance) {
+/* Returns 1 if the leaf a has to be openned before the leaf b. Like the update of the max bounds, ties go to the first
+ * leaf in the order of the tree. */
+static char isOpennedBefore(optimistic_instance* instance, optimistic_node* a, optimistic_node* b) {
 
-    optimistic_node* n = instance->nextOpennedNode;                                         // The leaf that is going to be open now
+    double boundA = VALUES(instance, a)->bounds[INDEX(a)];
+    double boundB = VALUES(instance, b)->bounds[INDEX(b)];
+
+    if(boundA != boundB)
+        return boundA > boundB;
+
+    while(a->depth > b->depth)
+        a = a->father;
+
+    while(b->depth > a->depth)
+        b = b->father;
+
+    while(a->father != b->father) {
+        a = a->father;
+        b = b->father;
+    }
+
+    return a->id < b->id;
+
+}
+
+
+static optimistic_node* mergeLeaves(optimistic_instance* instance, optimistic_node* a, optimistic_node* b) {
+
+    optimistic_node* tmp = NULL;
+
+    if(a == NULL)
+        return b;
+
+    if(b == NULL)
+        return a;
+
+    if(isOpennedBefore(instance, b, a)) {
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    b->queueSibling = a->queueChild;
+    a->queueChild = b;
+
+    return a;
+
+}
+
+
+static void pushLeaf(optimistic_instance* instance, optimistic_node* leaf) {
+
+    leaf->queueChild = NULL;
+    leaf->queueSibling = NULL;
+    instance->leafQueue = mergeLeaves(instance, instance->leafQueue, leaf);
+
+}
 
-    double crtDiscountedSum = ((optimistic_node_values*)n->values)->discountedSum;          // Let's take the current discounted sum of rewards for this trajectory
 
-    unsigned int crtDepth = ((optimistic_node_values*)n->values)->depth;                    // The current depth of this leaf or its position in the trajectory
+/* Removes the top of the queue by merging its children in two passes: by pairs from the first, then from the last pair. */
+static void popLeaf(optimistic_instance* instance) {
+
+    optimistic_node* crt = instance->leafQueue->queueChild;
+    optimistic_node* pairs = NULL;                                                          // The merged pairs, last first
+
+    while(crt != NULL) {
+        optimistic_node* a = crt;
+        optimistic_node* b = crt->queueSibling;
+
+        if(b == NULL) {
+            a->queueSibling = pairs;
+            pairs = a;
+            break;
+        }
+
+        crt = b->queueSibling;
+        a->queueSibling = NULL;
+        b->queueSibling = NULL;
+        a = mergeLeaves(instance, a, b);
+        a->queueSibling = pairs;
+        pairs = a;
+    }
+
+    instance->leafQueue = NULL;
+
+    while(pairs != NULL) {
+        crt = pairs;
+        pairs = pairs->queueSibling;
+        crt->queueSibling = NULL;
+        instance->leafQueue = mergeLeaves(instance, instance->leafQueue, crt);
+    }
+
+}
+
+
+/* Puts every open leaf of the tree in the queue. Closed branches are never propagated with the queue: a branch is
+ * closed when none of its leaves is in the queue. */
+static void fillLeafQueue(optimistic_instance* instance) {
+
+    optimistic_node* crt = instance->root;
+
+    instance->leafQueue = NULL;
+
+    while(1) {
+        while(crt->children != NULL)
+            crt = crt->children->nodes;
+
+        if(!VALUES(instance, crt)->isClosedBranch[INDEX(crt)])
+            pushLeaf(instance, crt);
+
+        while((crt != instance->root) && (crt->id >= (K - 1)))
+            crt = crt->father;
+
+        if(crt == instance->root)
+            break;
+
+        crt++;
+    }
+
+    instance->rootIsClosedBranch = instance->leafQueue == NULL;
+    if(instance->leafQueue != NULL)
+        instance->nextOpennedNode = instance->leafQueue;
+
+}
+
+
+/* Updates the max bounds of every node from the leaves, as they are not while the queue is used. */
+static void updateMaxBounds(optimistic_instance* instance) {
+
+    optimistic_node* crt = instance->root;
+
+    if(crt->children == NULL)
+        return;
+
+    crt = crt->children->nodes;
+
+    while(1) {
+        while(crt->children != NULL)
+            crt = crt->children->nodes;
+
+        while(crt->id >= (K - 1)) {
+            crt = crt->father;
+            crtKernel->updateMaxBound(VALUES(instance, crt), INDEX(crt), crt);
+
+            if(crt == instance->root) {
+                instance->nextOpennedNode = instance->rootLeaf;
+                return;
+            }
+        }
+
+        crt++;
+    }
+
+}
+
+
+/* Takes n out of the open leaves, counts its children in its ancestors and gives it the block of its children. Returns
+ * 0 and leaves everything as it was if the memory limit does not leave room for them, 1 else. */
+static char openLeaf(optimistic_instance* instance, optimistic_node* n) {
+
+    optimistic_node* crt = n;
+    unsigned int regionId = K;                                                              // The children of the root have their own region...
+    void* block = NULL;
+
+    while(crt != instance->root) {                                                          // ...the others go in the region of the root child they descend from
+        crt->nbNodes += K;
+        regionId = crt->id;
+        crt = crt->father;
+    }
+    crt->nbNodes += K;
+
+    block = region_alloc(instance->nodeRegions + regionId, instance->childrenSize);
+
+    if(block == NULL) {
+        for(crt = n; crt != NULL; crt = crt->father)
+            crt->nbNodes -= K;
+
+        return 0;
+    }
+
+    STATS_ADD(&instance->stats, nbAllocations, 1);
+
+    if(instance->isLeafQueueUsed)
+        popLeaf(instance);
+
+    n->children = initChildren(instance, block);
+
+    return 1;
+
+}
+
+
+/* The K children of n are simulated at once, unless the state of n is in the transposition table, the rewards go
+ * through the discounted sums. Only writes in the children of n so that several leaves can be simulated at the same
+ * time. */
+static void simulateChildren(optimistic_instance* instance, optimistic_node* n) {
+
+    if((instance->table == NULL) || !transposition_lookup(instance->table, n->s, n->children->nodes[0].s, n->children->discountedSums, n->children->isClosedBranch))
+        nextStatesRewardsInto(n->s, n->children->nodes[0].s, n->children->discountedSums, n->children->isClosedBranch);
+
+}
+
+
+/* Sets the values of the simulated children of n and puts the open ones in the queue when it is used. */
+static void addChildren(optimistic_instance* instance, optimistic_node* n) {
+
+    optimistic_children* values = VALUES(instance, n);
+    unsigned int id = INDEX(n);
+
+    double crtDiscountedSum = values->discountedSums[id];                                   // Let's take the current discounted sum of rewards for this trajectory
+
+    unsigned int crtDepth = n->depth;                                                       // The current depth of this leaf or its position in the trajectory
+
+    const double* gammaPowers = discount_getPowers(instance->discount, crtDepth + 1);
+    const double* bounds = discount_getBounds(instance->discount, crtDepth + 2);
 
     unsigned int i = 0;
 
-    n->children = (optimistic_node*)malloc(K * sizeof(optimistic_node));
+    if(instance->table != NULL)                                                             // Added before the rewards become discounted sums, and out of the parallel simulations
+        transposition_insert(instance->table, n->s, n->children->nodes[0].s, n->children->discountedSums, n->children->isClosedBranch);
+
     if(n == instance->crtOptimalLeaf)                                                       // If the current node being oponned is the current optimal then its first son will be the new current optimal one
         instance->crtOptimalValue = -1.0;
 
-    n->isClosedBranch = 1;                                                                  // Let's suppose that every new children will be associated to a terminal state
+    instance->crtNbEvaluations += K;
+    instance->totalNbEvaluations += K;
+    instance->realNbEvaluations += K;
 
     for(;i < K; i++) {
-        (n->children[i]).id = i;
-        (n->children[i]).trajectoryId = 0;
+        optimistic_node* child = n->children->nodes + i;
 
-        (n->children[i]).isClosedBranch = nextStateReward(n->s, actions[i], &((n->children[i]).s), &((n->children[i]).reward)) < 0 ? 1 : 0;
-        instance->crtNbEvaluations++;
-        instance->totalNbEvaluations++;
-        instance->realNbEvaluations++;
+        child->id = i;
+        child->trajectoryId = 0;
+        child->depth = crtDepth + 1;
+        child->nbNodes = 0;
 
-        if(crtDepth == ((OPTIMISTIC_MAX_DEPTH) - 1))
-            (n->children[i]).isClosedBranch = 1;
+        child->reward = n->children->discountedSums[i];
+        n->children->isClosedBranch[i] = n->children->isClosedBranch[i] < 0 ? 1 : 0;
 
-        (n->children[i]).values = (i == 0) ? n->values : malloc(sizeof(optimistic_node_values));    // The first children get its father values, the others get new ones
+        if((crtDepth - instance->root->depth) >= (instance->maxDepth - 1))
+            n->children->isClosedBranch[i] = 1;
 
-        ((optimistic_node_values*)(n->children[i]).values)->discountedSum = crtDiscountedSum + (instance->gammaPowers[crtDepth] *  (n->children[i]).reward);   // Actualization of the discounted sum of rewards
+        n->children->discountedSums[i] = crtDiscountedSum + (gammaPowers[crtDepth] * child->reward);              // Actualization of the discounted sum of rewards
 
-        ((optimistic_node_values*)(n->children[i]).values)->bound = ((optimistic_node_values*)(n->children[i]).values)->discountedSum + instance->bounds[crtDepth + 1];     // Computation of the bound for this new leaf
+        n->children->bounds[i] = n->children->discountedSums[i] + bounds[crtDepth + 1];                          // Computation of the bound for this new leaf
 
-        if(!(n->children[i]).isClosedBranch) {                                              // If this leaf is not closed
-            if(n->isClosedBranch) {                                                         // If my father still supposes all its children will be closed then...
-                n->isClosedBranch = 0;                                                      // ...it's not the case, father
-                n->values = (void*)(n->children + i);                                       // Let's put this children as a reference for the max bound
-                n->trajectoryId = i;
-            } else if(((optimistic_node_values*)((optimistic_node*)n->values)->values)->bound < ((optimistic_node_values*)(n->children[i]).values)->bound) {    // Else if this children bound is the biggest then...
-                n->values = (void*)(n->children + i);                                       // ...let's put if as the reference for the max bound
-                n->trajectoryId = i;
-            }
-        }
+        n->children->leaves[i] = child;
 
-        if(((optimistic_node_values*)(n->children[i]).values)->discountedSum > instance->crtOptimalValue) {     // If it's the best then let's save its value, its address and the root action that was taken
-            instance->crtOptimalValue = ((optimistic_node_values*)(n->children[i]).values)->discountedSum;
-            instance->crtOptimalLeaf = n->children + i;
-            instance->crtOptimalAction = instance->root->trajectoryId;
+        if(n->children->discountedSums[i] > instance->crtOptimalValue) {                   // If it's the best then let's save its value and its address, the root action is found at the end of the planning
+            instance->crtOptimalValue = n->children->discountedSums[i];
+            instance->crtOptimalLeaf = child;
         }
 
-        ((optimistic_node_values*)(n->children[i]).values)->depth = crtDepth + 1;
+        child->children = NULL;
+        child->father = n;
 
-        (n->children[i]).children = NULL;
-        (n->children[i]).father = n;
+        if(instance->isLeafQueueUsed && !n->children->isClosedBranch[i])
+            pushLeaf(instance, child);
     }
 
-    n = n->father;                                                                          // Let's update the max overal bound starting from the father of the openned leaf (which is not one anymore)
+}
 
-    while(n != NULL) {
 
-        unsigned int i = 0;
+static void updateCrtOptimalAction(optimistic_instance* instance) {
 
-        n->isClosedBranch = 1;                                                              // As before let's suppose this node is closed
-
-        for(; i < K; i++) {
-            if(!(n->children[i]).isClosedBranch) {                                          // If one of its children is not closed
-                if(n->isClosedBranch) {                                                     // If every children was closed but not this one
-                    n->isClosedBranch = 0;                                                  // Then this node is not closed
-
-                    if((n->children[i]).children == NULL)                                   // If this child is a leaf
-                        n->values = (void*)(n->children + i);
-                    else
-                        n->values = (n->children[i]).values;
-
-                    n->trajectoryId = i;
-
-                } else if((n->children[i]).children == NULL) {                              // Else this node is not closed anyway so is this child a leaf ?
-                    if(((optimistic_node_values*)(n->children[i]).values)->bound > ((optimistic_node_values*)((optimistic_node*)(n->values))->values)->bound) {
-                        n->values = (void*)(n->children + i);
-                        n->trajectoryId = i;
-                    }
-                } else {
-                    if(((optimistic_node_values*)((optimistic_node*)(n->children[i]).values)->values)->bound > ((optimistic_node_values*)((optimistic_node*)(n->values))->values)->bound) {
-                        n->values = (n->children[i]).values;
-                        n->trajectoryId = i;
-                    }
-                }
-            }
+    optimistic_node* crt = instance->crtOptimalLeaf;
+
+    if(crt == instance->root)
+        return;
+
+    instance->crtOptimalValue = crt->father->children->discountedSums[crt->id];
+
+    while(crt->father != instance->root)
+        crt = crt->father;
+
+    instance->crtOptimalAction = crt->id;
+
+}
+
+
+/* Releases the region of the root child subtree with the lowest bound, the closed ones first, which does not contain
+ * n or the optimal leaf. Its root child is then a closed leaf. Returns 0 if no region has memory to give back, 1 else. */
+static char pruneSubtree(optimistic_instance* instance, optimistic_node* n) {
+
+    optimistic_children* children = instance->root->children;
+    optimistic_node* pruned = NULL;
+    double minBound = HUGE_VAL;
+    unsigned int i = 0;
+
+    if(children == NULL)
+        return 0;
+
+    while(n->father != instance->root)
+        n = n->father;
+
+    updateCrtOptimalAction(instance);
+
+    for(; i < K; i++) {
+        double bound = children->isClosedBranch[i] ? -HUGE_VAL : children->bounds[i];         // Not up to date with the queue but still a bound
+
+        if((i != n->id) && (i != instance->crtOptimalAction) && (region_getSize(instance->nodeRegions + i) > 0) && ((pruned == NULL) || (bound < minBound))) {
+            pruned = children->nodes + i;
+            minBound = bound;
         }
+    }
+
+    if(pruned == NULL)
+        return 0;
+
+    releaseRegion(instance, instance->nodeRegions + pruned->id);                                     // What was kept from previous roots is only released with them
+
+    instance->root->nbNodes -= pruned->nbNodes;
+    pruned->nbNodes = 0;
+    pruned->children = NULL;
+    children->isClosedBranch[pruned->id] = 1;
+    children->leaves[pruned->id] = pruned;
+    instance->nbPrunedSubtrees++;
+
+    if(instance->isLeafQueueUsed) {
+        fillLeafQueue(instance);
+    } else {
+        crtKernel->updateMaxBound(&instance->rootValues, 0, instance->root);
+        instance->nextOpennedNode = instance->rootLeaf;
+    }
+
+    return 1;
+
+}
 
-        n = n->father;                                                                      // Update done for this node, let's move on to its father
+
+static void buildingTrajectory(optimistic_instance* instance) {
+
+    optimistic_node* n = instance->nextOpennedNode;                                         // The leaf that is going to be open now
+
+    if(!openLeaf(instance, n)) {
+        if(!instance->isPruningUsed || !pruneSubtree(instance, n))                          // The next leaf is the one to open once a subtree is released
+            instance->isMemoryFull = 1;
+        return;
     }
 
-    instance->nextOpennedNode = (optimistic_node*)instance->root->values;                   // The next leaf to be openned
+    STATS_TIME(&instance->stats, simulationTime, simulateChildren(instance, n));
+    STATS_TIME(&instance->stats, bookkeepingTime, addChildren(instance, n));
+
+    if(instance->isLeafQueueUsed) {                                                         // The queue gives the next leaf to be openned without updating the ancestors
+        instance->rootIsClosedBranch = instance->leafQueue == NULL;
+        instance->nextOpennedNode = instance->leafQueue;
+        return;
+    }
+
+    STATS_TIME(&instance->stats, bookkeepingTime, crtKernel->updateAncestors(instance, n));     // Let's update the max overal bound starting from the openned leaf (which is not one anymore)
+
+    instance->nextOpennedNode = instance->rootLeaf;                                         // The next leaf to be openned
+
+}
+
+
+static void simulateOpennedLeaf(void* data, unsigned int taskId) {
+
+    optimistic_instance* instance = (optimistic_instance*)data;
+
+    STATS_TIME(&instance->stats, simulationTime, simulateChildren(instance, instance->opennedLeaves[taskId]));
+
+}
+
+
+/* Speculative round: the best bounded open leaves, as many as there are threads, are taken out of the queue in order
+ * and simulated at the same time. Their children are then added in that same order, so that the tree does not depend
+ * on which thread was the fastest. */
+static void buildingTrajectories(optimistic_instance* instance, unsigned int maxNbEvaluations) {
+
+    unsigned int nbLeaves = instance->nbThreads;
+    unsigned int i = 0;
+
+    if(instance->isEvaluationCountKept) {                                                   // No more leaves than what the sequential planning would still open
+        unsigned int nbLeftLeaves = (maxNbEvaluations - instance->crtNbEvaluations + K - 1) / K;
+
+        if(nbLeftLeaves < nbLeaves)
+            nbLeaves = nbLeftLeaves;
+    }
+
+    for(; (i < nbLeaves) && (instance->leafQueue != NULL); i++) {
+        instance->opennedLeaves[i] = instance->leafQueue;
+
+        if(!openLeaf(instance, instance->leafQueue)) {                                      // The round ends with the leaves already openned...
+            if((i == 0) && (!instance->isPruningUsed || !pruneSubtree(instance, instance->leafQueue)))
+                instance->isMemoryFull = 1;                                                 // ...and as the queue is filled again, a subtree is only released before the first one
+            break;
+        }
+    }
+
+    nbLeaves = i;
+
+    thread_pool_run(instance->threads, simulateOpennedLeaf, instance, nbLeaves);
+
+    for(i = 0; i < nbLeaves; i++)
+        STATS_TIME(&instance->stats, bookkeepingTime, addChildren(instance, instance->opennedLeaves[i]));
+
+    instance->rootIsClosedBranch = instance->leafQueue == NULL;
+    instance->nextOpennedNode = instance->leafQueue;
 
 }
 
@@ -245,119 +602,252 @@ action* optimistic_planning(optimistic_instance* instance, unsigned int maxNbEva
 
     unsigned int cpt = 15000000;
     instance->realNbEvaluations = 0;
+    instance->isMemoryFull = 0;
+    instance->nbPrunedSubtrees = 0;
 
-    while((instance->crtNbEvaluations < maxNbEvaluations) && !instance->root->isClosedBranch) {
+    while((instance->crtNbEvaluations < maxNbEvaluations) && !instance->rootIsClosedBranch && !instance->isMemoryFull && !deadline_isOver(&instance->clock)) {
         if(instance->crtNbEvaluations > cpt){
             printf("%u evaluations done\n", cpt);
             cpt+=15000000;
         }
 
-        buildingTrajectory(instance);
+        if((instance->threads != NULL) && instance->isLeafQueueUsed)                        // The parallel rounds take their leaves from the queue
+            buildingTrajectories(instance, maxNbEvaluations);
+        else
+            buildingTrajectory(instance);
     }
 
+    updateCrtOptimalAction(instance);
+
+    STATS_SET(&instance->stats, nbNodes, instance->root->nbNodes + 1);
+    STATS_SET(&instance->stats, maxDepth, optimistic_getMaxDepth(instance));
+
     return actions[instance->crtOptimalAction];
 
 }
 
 
+/* Same as optimistic_planning, but also stops at deadline, in nanoseconds on the clock of deadline_now, and then
+ * returns the best action found so far. The number of evaluations done is in realNbEvaluations. */
+action* optimistic_planningDeadline(optimistic_instance* instance, unsigned int maxNbEvaluations, uint64_t deadline) {
+
+    action* a = NULL;
+
+    deadline_start(&instance->clock, deadline);
+    a = optimistic_planning(instance, maxNbEvaluations);
+    deadline_start(&instance->clock, 0);
+
+    return a;
+
+}
+
+
+/* Makes room for the discounted sums of a path of nbDepths depths at least. */
+static void reservePath(optimistic_instance* instance, unsigned int nbDepths) {
+
+    if(nbDepths > instance->pathSize) {
+        instance->pathSize = nbDepths > (2 * instance->pathSize) ? nbDepths : 2 * instance->pathSize;
+        instance->pathDiscountedSums = (double*)realloc(instance->pathDiscountedSums, sizeof(double) * instance->pathSize);
+    }
+
+}
+
+
+/* Rebases the discounted sums, the bounds and the depths on the root. */
 static void updateValues(optimistic_instance* instance) {
 
     unsigned int crtDepth = 1;
-
-    optimistic_node* crt = instance->root->children;
-    instance->crtOptimalValue = 0.0;
+    double* crtDiscountedSums = NULL;
+    const double* gammaPowers = NULL;
+    const double* bounds = NULL;
+
+    optimistic_node* crt = instance->root->children->nodes;
+    instance->root->depth = 0;
+    instance->rootDiscountedSum = 0.0;
+
+    reservePath(instance, 1);
+    crtDiscountedSums = instance->pathDiscountedSums;
+    gammaPowers = discount_getPowers(instance->discount, instance->pathSize + 1);
+    bounds = discount_getBounds(instance->discount, instance->pathSize + 1);
     crtDiscountedSums[0] = 0.0;
 
     while(1) {
         while(crt->children != NULL) {
-            crtDiscountedSums[crtDepth] = crtDiscountedSums[crtDepth-1] + (instance->gammaPowers[crtDepth - 1] * crt->reward);
-            crtDepth++;
-            instance->crtNbEvaluations++;
-            crt = crt->children;
-        }
-
-        instance->crtNbEvaluations++;
-        ((optimistic_node_values*)crt->values)->discountedSum = crtDiscountedSums[crtDepth-1] + (instance->gammaPowers[crtDepth - 1] * crt->reward);
+            if(crtDepth >= instance->pathSize) {                                            // The arrays cover the depths up to pathSize
+                reservePath(instance, crtDepth + 1);
+                crtDiscountedSums = instance->pathDiscountedSums;
+                gammaPowers = discount_getPowers(instance->discount, instance->pathSize + 1);
+                bounds = discount_getBounds(instance->discount, instance->pathSize + 1);
+            }
 
-        if(((optimistic_node_values*)crt->values)->discountedSum > instance->crtOptimalValue) {
-            instance->crtOptimalValue = ((optimistic_node_values*)crt->values)->discountedSum;
-            instance->crtOptimalLeaf = crt;
+            crtDiscountedSums[crtDepth] = crtDiscountedSums[crtDepth-1] + (gammaPowers[crtDepth - 1] * crt->reward);
+            crt->father->children->discountedSums[crt->id] = crtDiscountedSums[crtDepth];
+            crt->depth = crtDepth;
+            crtDepth++;
+            crt = crt->children->nodes;
         }
 
-        ((optimistic_node_values*)crt->values)->bound = ((optimistic_node_values*)crt->values)->discountedSum + instance->bounds[crtDepth];
-        ((optimistic_node_values*)crt->values)->depth = crtDepth;
+        crt->father->children->discountedSums[crt->id] = crtDiscountedSums[crtDepth-1] + (gammaPowers[crtDepth - 1] * crt->reward);
+        crt->father->children->bounds[crt->id] = crt->father->children->discountedSums[crt->id] + bounds[crtDepth];
+        crt->depth = crtDepth;
 
-        while(crt && (crt->id >= (K - 1))) {
+        while(crt->id >= (K - 1)) {                                                         // Every child of the father is done so its max bound can be updated
             crtDepth--;
             crt = crt->father;
+            crtKernel->updateMaxBound(VALUES(instance, crt), INDEX(crt), crt);
+
+            if(crt == instance->root)
+                return;
         }
 
-        if(crt)
-            crt = crt->father->children + crt->id + 1;
-        else
-            return;
+        crt++;
     }
 
 }
 
 
-static void updateCrtOptimalAction(optimistic_instance* instance) {
+static void updateNextOpennedNode(optimistic_instance* instance) {
 
-    instance->crtOptimalValue = ((optimistic_node_values*)instance->crtOptimalLeaf->values)->discountedSum;
-    optimistic_node* crt = instance->crtOptimalLeaf;
+    optimistic_node* crt = instance->root;
 
-    while(crt->father->father)
-        crt = crt->father;
+    while(crt->children != NULL)
+        crt = crt->children->nodes + crt->trajectoryId;
 
-    instance->crtOptimalAction = crt->id;
+    instance->nextOpennedNode = crt;
 
 }
 
 
-static void updateNextOpennedNode(optimistic_instance* instance) {
+static optimistic_node* moveChildren(optimistic_instance* instance, optimistic_node* n, unsigned int regionId) {
+
+    void* block = region_alloc(instance->nodeRegions + regionId, instance->childrenSize);
+    optimistic_children* children = NULL;
+    unsigned int i = 0;
+
+    STATS_ADD(&instance->stats, nbAllocations, 1);
+
+    memcpy(block, n->children, instance->childrenSize);
+    children = initChildren(instance, block);
+
+    for(; i < K; i++) {
+        n->children->nodes[i].father = children->nodes + i;                                 // The old node now forwards to its copy
+        children->nodes[i].father = n;
+    }
+
+    n->children = children;
+
+    return children->nodes;
+
+}
+
+
+/* Copies the tree below the root into the current regions, then releases what was kept from previous roots. */
+static void evacuateTree(optimistic_instance* instance) {
 
     optimistic_node* crt = instance->root;
+    unsigned int regionId = K;
+    unsigned int i = 0;
 
-    while(crt->children != NULL)
-        crt = crt->children + crt->trajectoryId;
+    while(1) {                                                                              // First pass: copy every block of children
+        while(crt->children != NULL) {
+            if(crt->father == instance->root)
+                regionId = crt->id;
 
-    instance->nextOpennedNode = crt;
+            crt = moveChildren(instance, crt, crt == instance->root ? K : regionId);
+        }
+
+        while((crt != instance->root) && (crt->id >= (K - 1)))
+            crt = crt->father;
+
+        if(crt == instance->root)
+            break;
+
+        crt++;
+    }
+
+    while(1) {                                                                              // Second pass: make the children point to the copies of their max bounded leaves
+        while(crt->children != NULL) {
+            for(i = 0; i < K; i++)
+                crt->children->leaves[i] = crt->children->leaves[i]->father;
+
+            crt = crt->children->nodes;
+        }
+
+        while((crt != instance->root) && (crt->id >= (K - 1)))
+            crt = crt->father;
+
+        if(crt == instance->root)
+            break;
+
+        crt++;
+    }
+
+    if(!instance->isLeafQueueUsed)                                                          // Not kept up to date with the queue
+        instance->rootLeaf = instance->rootLeaf->father;
+    instance->crtOptimalLeaf = instance->crtOptimalLeaf->father;
+
+    releaseRegion(instance, &instance->oldNodes);
 
 }
 
 
-void optimistic_keepSubtree(optimistic_instance* instance) {
+static void keepSubtree(optimistic_instance* instance) {
 
     if(instance->root->children) {
         unsigned int i = 0;
         unsigned int keptSubtreeId = instance->crtOptimalAction;
-        optimistic_node* cuttedSubtrees = instance->root->children;
+        optimistic_children* cuttedSubtrees = instance->root->children;
+        optimistic_node* keptSubtree = cuttedSubtrees->nodes + keptSubtreeId;
 
-        freeState(instance->root->s);
-        instance->root->s = (cuttedSubtrees[keptSubtreeId]).s;
+        memcpy(instance->root->s, keptSubtree->s, instance->stateSize);                     // The state of the root is the only one not in a region
         instance->root->reward = 0.0;
-        instance->root->values = (cuttedSubtrees[keptSubtreeId]).values;
-        instance->root->trajectoryId = (cuttedSubtrees[keptSubtreeId]).trajectoryId;
-        instance->root->children = (cuttedSubtrees[keptSubtreeId]).children;
-
-        for(; i < keptSubtreeId; i++)
-            deleteTree(cuttedSubtrees + i);
-        for(i = keptSubtreeId + 1; i < K; i++)
-            deleteTree(cuttedSubtrees + i);
-        free(cuttedSubtrees);
-        
-        instance->crtOptimalValue = 0.0;
-        instance->crtNbEvaluations = 0;
+        instance->root->depth = keptSubtree->depth;                                         // The values below stay the ones from the previous roots
+        instance->root->nbNodes = keptSubtree->nbNodes;
+        instance->root->trajectoryId = keptSubtree->trajectoryId;
+        instance->root->children = keptSubtree->children;
+        instance->rootBound = cuttedSubtrees->bounds[keptSubtreeId];
+        instance->rootDiscountedSum = cuttedSubtrees->discountedSums[keptSubtreeId];
+        instance->rootLeaf = cuttedSubtrees->leaves[keptSubtreeId];
+        instance->rootIsClosedBranch = cuttedSubtrees->isClosedBranch[keptSubtreeId];
+
+        region_append(&instance->oldNodes, instance->nodeRegions + keptSubtreeId);         // The kept subtree joins what was kept from previous roots...
+
+        for(i = 0; i < K; i++) {                                                            // ...and the cutted ones are released at once
+            if(i != keptSubtreeId)
+                releaseRegion(instance, instance->nodeRegions + i);
+        }
+        releaseRegion(instance, instance->nodeRegions + K);
+
+        instance->crtNbEvaluations = instance->root->nbNodes;
 
         if(instance->root->children == NULL) {
+            releaseRegion(instance, &instance->oldNodes);
+
+            instance->root->depth = 0;
+            instance->rootBound = discount_getBounds(instance->discount, 1)[0];
+            instance->rootDiscountedSum = 0.0;
+            instance->crtOptimalValue = 0.0;
+            instance->rootLeaf = instance->root;
             instance->nextOpennedNode = instance->root;
+            instance->leafQueue = instance->rootIsClosedBranch ? NULL : instance->root;
+            instance->root->queueChild = NULL;
+            instance->root->queueSibling = NULL;
             instance->crtOptimalAction = 0;
             instance->crtOptimalLeaf = instance->root;
         } else {
             for(i = 0; i < K; i++)
-                (instance->root->children[i]).father = instance->root;
-            updateValues(instance);
-            updateNextOpennedNode(instance);
+                instance->root->children->nodes[i].father = instance->root;
+
+            if((instance->root->depth >= instance->maxDepth) || (discount_getPowers(instance->discount, instance->root->depth + 1)[instance->root->depth] < MIN_ROOT_GAMMA_POWER))
+                STATS_TIME(&instance->stats, updateValuesTime, updateValues(instance));
+
+            if(((K * region_getSize(&instance->oldNodes)) > (2 * instance->crtNbEvaluations * instance->childrenSize)) && region_hasRoomFor(instance->pool, instance->crtNbEvaluations / K, instance->childrenSize, K + 1))
+                evacuateTree(instance);                                                     // Once more than half of the old regions is dead, copying the rest costs less than what it frees
+
+            if(instance->isLeafQueueUsed)
+                fillLeafQueue(instance);
+            else
+                updateNextOpennedNode(instance);
             updateCrtOptimalAction(instance);
         }
     }
@@ -365,11 +855,47 @@ void optimistic_keepSubtree(optimistic_instance* instance) {
 }
 
 
+void optimistic_keepSubtree(optimistic_instance* instance) {
+
+    STATS_TIME(&instance->stats, keepSubtreeTime, keepSubtree(instance));
+
+}
+
+
+void optimistic_setLeafQueue(optimistic_instance* instance, char isLeafQueueUsed) {
+
+    if(instance->isLeafQueueUsed == isLeafQueueUsed)
+        return;
+
+    instance->isLeafQueueUsed = isLeafQueueUsed;
+
+    if(instance->root == NULL)
+        return;
+
+    if(isLeafQueueUsed)
+        fillLeafQueue(instance);
+    else
+        updateMaxBounds(instance);
+
+}
+
+
 void optimistic_uninitInstance(optimistic_instance** instance) {
 
-    deleteTree((*instance)->root);
+    deleteTree(*instance);
     free((*instance)->root);
 
+    free((*instance)->nodeRegions);
+    region_uninitPool(&(*instance)->pool);
+
+    if((*instance)->threads != NULL) {
+        thread_pool_uninit(&(*instance)->threads);
+        free((*instance)->opennedLeaves);
+    }
+
+    free((*instance)->pathDiscountedSums);
+    discount_releaseTable(&(*instance)->discount);
+
     free((*instance));
     *instance = NULL;
 
@@ -384,7 +910,7 @@ static unsigned int getMaxDepth(optimistic_node* crt) {
     while(1) {
         while(crt->children != NULL) {
             crtDepth++;
-            crt = crt->children;
+            crt = crt->children->nodes;
         }
 
         if(crtDepth > maxDepth)
@@ -396,7 +922,7 @@ static unsigned int getMaxDepth(optimistic_node* crt) {
         }
 
         if(crt)
-            crt = crt->father->children + crt->id + 1;
+            crt++;
         else
             break;
     }
@@ -406,8 +932,67 @@ static unsigned int getMaxDepth(optimistic_node* crt) {
 }
 
 
+/* Plans on nbThreads threads if there are more than one, by rounds of as many leaves taken from the queue of the open
+ * leaves, which is then used. With isEvaluationCountKept, a planning does not do more evaluations than a sequential one
+ * would: the last round may open less leaves. */
+void optimistic_setThreads(optimistic_instance* instance, unsigned int nbThreads, char isEvaluationCountKept) {
+
+    if(instance->threads != NULL) {
+        thread_pool_uninit(&instance->threads);
+        free(instance->opennedLeaves);
+        instance->opennedLeaves = NULL;
+    }
+
+    instance->nbThreads = nbThreads > 0 ? nbThreads : 1;
+    instance->isEvaluationCountKept = isEvaluationCountKept;
+
+    if(instance->nbThreads > 1) {
+        instance->threads = thread_pool_init(instance->nbThreads);
+        instance->opennedLeaves = (optimistic_node**)malloc(sizeof(optimistic_node*) * instance->nbThreads);
+        optimistic_setLeafQueue(instance, 1);
+    }
+
+}
+
+
+/* Bounds the memory taken by the nodes below the root, their values and states included, to maxNbBytes (0 for no bound).
+ * A planning reaching it stops, or with isPruningUsed, releases the least promising subtrees of the root as long as one
+ * of them has memory to give back. */
+void optimistic_setMemoryLimit(optimistic_instance* instance, size_t maxNbBytes, char isPruningUsed) {
+
+    region_setPoolLimit(instance->pool, maxNbBytes);
+    instance->isPruningUsed = isPruningUsed;
+
+}
+
+
+/* The children of the leaves are looked up in table, if it is not NULL, before being simulated, and the ones
+ * simulated are added to it. The table is not released with the instance. */
+void optimistic_setTranspositionTable(optimistic_instance* instance, transposition_table* table) {
+
+    instance->table = table;
+
+}
+
+
+/* The leaves maxDepth - 1 deeper than the root are not openned, OPTIMISTIC_MAX_DEPTH - 1 by default. */
+void optimistic_setMaxDepth(optimistic_instance* instance, unsigned int maxDepth) {
+
+    instance->maxDepth = maxDepth > 1 ? maxDepth : 2;
+
+}
+
+
+/* The cutted subtrees are released by the reclaimer if it is not NULL. */
+void optimistic_setReclaimer(optimistic_instance* instance, region_reclaimer* reclaimer) {
+
+    region_setReclaimer(instance->pool, reclaimer);
+
+}
+
+
 unsigned int optimistic_getMaxDepth(optimistic_instance* instance) {
 
-    return instance->root->children ? getMaxDepth(instance->root->children) - 1 : 0;
+    return instance->root->children ? getMaxDepth(instance->root->children->nodes) - 1 : 0;
 
 }
@@ -35,31 +35,42 @@
 #ifndef OPTIMISTIC_H
 #define OPTIMISTIC_H
 
-#ifdef LIMITED_DEPTH
-    #define OPTIMISTIC_MAX_DEPTH 512
-#else
-    #define OPTIMISTIC_MAX_DEPTH 32768
-#endif
+#define OPTIMISTIC_MAX_DEPTH 32768      // Default depth limit of the tree below the root
 
 #include "../../problems/generative_model.h"
+#include "../region/region.h"
+#include "../thread_pool/thread_pool.h"
+#include "../transposition/transposition.h"
+#include "../discount/discount.h"
+#include "../deadline/deadline.h"
+#include "../stats/stats.h"
 
-typedef struct {
-		double bound;				// Bound on a leaf.
-		double discountedSum;		// Discounted sum to a leaf.
-		unsigned int depth;			// Depth of a leaf.
-}	optimistic_node_values;
-
+/* Depths and discounted sums are the ones from the root the instance was reset on, so that keeping a subtree does not
+ * change any of them: from the current root, a discounted sum v is worth (v - rootDiscountedSum) / gammaPowers[depth of
+ * the root]. They are only rebased on the current root once this power of gamma gets too small. */
 typedef struct optimistic_node_struct {
         state* s;                           // The state associated with this node
         double reward;                      // The reward associated with the transition to this state
-		void* values;						// If is a node, point to the leaf containing the max bound else point to the value of the leaf.
+		unsigned int depth;					// Depth of the node.
 		unsigned int trajectoryId;			// Index of the child containing the max bounded leaf.
 		unsigned int id;					// Index of the node in the children array of his father. Not useful for root node.
-		char isClosedBranch;				// 1 if leaves from this node or the current leaf don't need to be openned later, 0 else.
+		unsigned int nbNodes;				// Number of nodes below this node.
 		struct optimistic_node_struct* father;					// Father of the node. NULL if node is the root.
-		struct optimistic_node_struct* children;				// Array of K children. NULL if node is a leaf.
+		struct optimistic_children_struct* children;			// The K children. NULL if node is a leaf.
+		struct optimistic_node_struct* queueChild;				// First child of a leaf in the queue of leaves.
+		struct optimistic_node_struct* queueSibling;			// Next sibling of a leaf in the queue of leaves.
 }	optimistic_node;
 
+/* The K children of a node are allocated as one block. What is compared between siblings is packed in arrays of K
+ * so that looking for the max bound reads a few contiguous values instead of following a pointer per child. */
+typedef struct optimistic_children_struct {
+		double* bounds;						// Bound of each leaf or, for a node, the bound of its max bounded leaf.
+		double* discountedSums;				// Discounted sum to each child.
+		struct optimistic_node_struct** leaves;					// Max bounded leaf of each subtree. The child itself if it is a leaf.
+		char* isClosedBranch;				// 1 if leaves from this child or the child itself don't need to be openned later, 0 else.
+		struct optimistic_node_struct* nodes;					// The K children.
+}	optimistic_children;
+
 typedef struct {
 
         double gamma;
@@ -74,17 +85,56 @@ typedef struct {
 
         optimistic_node* crtOptimalLeaf;
 
-        double gammaPowers[OPTIMISTIC_MAX_DEPTH];
-        double bounds[OPTIMISTIC_MAX_DEPTH];
+        discount_table* discount;           // Shared by the instances of the same discount factor
+        unsigned int maxDepth;              // Leaves maxDepth - 1 deeper than the root are closed
+
+        double* pathDiscountedSums;         // Discounted sums along the path being rebased
+        unsigned int pathSize;
 
         optimistic_node* nextOpennedNode;
 
+        char isLeafQueueUsed;               // 1 if the next leaf to open is taken from a queue of the open leaves, 0 if it is found by updating the max bounds up to the root
+        optimistic_node* leafQueue;         // Pairing heap of the open leaves, the max bounded one on top
+
+        thread_pool* threads;               // Threads simulating several leaves at once. NULL if the planning is sequential
+        unsigned int nbThreads;
+        char isEvaluationCountKept;         // 1 if a parallel planning does not do more evaluations than a sequential one, 0 else
+        optimistic_node** opennedLeaves;    // The leaves openned in the current parallel round
+
+        char isPruningUsed;                 // 1 if the least promising subtrees are released when the tree reaches the memory limit, 0 if the planning stops
+        char isMemoryFull;                  // 1 if the last planning stopped at the memory limit, 0 else
+        unsigned int nbPrunedSubtrees;      // Number of subtrees released by the last planning to stay within the memory limit
+
+        transposition_table* table;         // Where the children of a leaf are looked up before being simulated. NULL if there is none
+
+        deadline_clock clock;               // Deadline of the planning being done, if it has one
+        stats_counters stats;               // Where the time of the plannings goes, counted when built with USE_STATS
+
+        optimistic_children rootValues;     // The values of the root, seen as the only child of a missing father
+        double rootBound;
+        double rootDiscountedSum;
+        optimistic_node* rootLeaf;
+        char rootIsClosedBranch;
+
+        size_t stateSize;                   // Size of a state of the generative model
+        size_t childrenSize;                // Size of a block of K children, their states included
+        region_pool* pool;                  // Chunks shared by every region of the instance
+        region* nodeRegions;                // K + 1 regions: the children of each root child subtree, then the children of the root
+        region oldNodes;                    // Children kept from previous roots
+
 }   optimistic_instance;
 
 optimistic_instance* optimistic_initInstance(state* initial, double discountFactor);
 void optimistic_resetInstance(optimistic_instance* instance, state* initial);
 action* optimistic_planning(optimistic_instance* instance, unsigned int maxNbEvaluations);
+action* optimistic_planningDeadline(optimistic_instance* instance, unsigned int maxNbEvaluations, uint64_t deadline);
 void optimistic_keepSubtree(optimistic_instance* instance);
+void optimistic_setReclaimer(optimistic_instance* instance, region_reclaimer* reclaimer);
+void optimistic_setLeafQueue(optimistic_instance* instance, char isLeafQueueUsed);
+void optimistic_setThreads(optimistic_instance* instance, unsigned int nbThreads, char isEvaluationCountKept);
+void optimistic_setMemoryLimit(optimistic_instance* instance, size_t maxNbBytes, char isPruningUsed);
+void optimistic_setTranspositionTable(optimistic_instance* instance, transposition_table* table);
+void optimistic_setMaxDepth(optimistic_instance* instance, unsigned int maxDepth);
 unsigned int optimistic_getMaxDepth(optimistic_instance* instance);
 void optimistic_uninitInstance(optimistic_instance** instance);
 
@@ -51,7 +51,7 @@ static void drawTree(SDL_Surface* screen, optimistic_node* n, double start, doub
         for(; i < K; i++) {
             startChild = start + (i * spaceBetween);
             stopChild = startChild + spaceBetween;
-            drawTree(screen, n->children + i, startChild, stopChild, depthChild, hSpaceTree);
+            drawTree(screen, n->children->nodes + i, startChild, stopChild, depthChild, hSpaceTree);
             aalineRGBA(screen, start + ((stop-start) / 2), depth * hSpaceTree, startChild + (spaceBetween / 2), depthChild * hSpaceTree , 0, 0, 0, 255);
         }
     }
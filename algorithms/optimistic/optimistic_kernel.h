@@ -0,0 +1,74 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+/* The loops of the optimistic planning over the children of a node, compiled by optimistic.c once per branching factor
+ * through ../kernel/kernel.h. */
+
+/* Sets the values of n from the ones of its children: closed or not, and if not, the max bound and where it is. */
+static void KERNEL(updateMaxBound)(optimistic_children* values, unsigned int id, optimistic_node* n) {
+
+    optimistic_children* children = n->children;
+    double maxBound = -HUGE_VAL;
+    char isClosedBranch = 1;
+    unsigned int i = 0;
+
+    for(; i < KERNEL_K; i++) {                                                              // No branch in there so that it can be vectorized
+        double bound = children->isClosedBranch[i] ? -HUGE_VAL : children->bounds[i];
+        maxBound = (bound > maxBound) ? bound : maxBound;
+        isClosedBranch &= children->isClosedBranch[i];
+    }
+
+    values->isClosedBranch[id] = isClosedBranch;
+
+    if(!isClosedBranch) {
+        for(i = 0; children->isClosedBranch[i] || (children->bounds[i] != maxBound); i++);   // The first child with the max bound, as when comparing one by one
+
+        values->bounds[id] = maxBound;
+        values->leaves[id] = children->leaves[i];
+        n->trajectoryId = i;
+    }
+
+}
+
+
+/* Updates the max bounds from the openned leaf n up to the root. */
+static void KERNEL(updateAncestors)(optimistic_instance* instance, optimistic_node* n) {
+
+    for(; n != NULL; n = n->father)
+        KERNEL(updateMaxBound)(VALUES(instance, n), INDEX(n), n);
+
+}
+
+
+static const optimistic_kernel KERNEL(kernel) = {KERNEL(updateMaxBound), KERNEL(updateAncestors)};
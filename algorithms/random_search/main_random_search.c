@@ -34,7 +34,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 #include <unistd.h>
+#include <time.h>
 #include <argtable2.h>
 
 #include "../../problems/generative_model.h"
@@ -47,6 +50,52 @@
 #include "random_search.h"
 
 
+/* The planning of a step, done by the main thread or, in the pipelined mode, by the planner thread while the last
+ * action is applied. */
+typedef struct {
+    random_search_instance* instance;
+    unsigned int maxNbEvaluations;
+    unsigned int deadline;              // Time in microseconds the planning is given from its start, 0 if it has none
+    action* optimalAction;
+    FILE* statsFile;                    // Where the counters of the planning are written, NULL if they are not
+    char isCsv;
+    unsigned int step;                  // Step the planning is for
+}   planning_job;
+
+
+static void* plan(void* data) {
+
+    planning_job* job = (planning_job*)data;
+    uint64_t start = deadline_now();
+
+    if(job->deadline > 0)
+        job->optimalAction = random_search_planningDeadline(job->instance, job->maxNbEvaluations, deadline_now() + ((uint64_t)job->deadline * 1000));
+    else
+        job->optimalAction = random_search_planning(job->instance, job->maxNbEvaluations);
+
+    if(job->statsFile != NULL) {
+        stats_write(job->statsFile, job->isCsv, job->step, job->instance->realNbEvaluations, deadline_now() - start, &job->instance->stats);
+        stats_reset(&job->instance->stats);
+    }
+
+    return NULL;
+
+}
+
+
+/* Returns 1 if a and b are the same state, their padding left out, 0 else. keys has room for two keys. */
+static char isSameState(state* a, state* b, double* keys) {
+
+    unsigned int keyLength = getStateKeyLength();
+
+    getStateKey(a, 0.0, keys);
+    getStateKey(b, 0.0, keys + keyLength);
+
+    return memcmp(keys, keys + keyLength, sizeof(double) * keyLength) == 0;
+
+}
+
+
 int main(int argc, char* argv[]) {
 
     double discountFactor;
@@ -54,6 +103,13 @@ int main(int argc, char* argv[]) {
     char isTerminal = 0;
     int nbTimestep = -1;
     unsigned int branchingFactor = 0;
+    char isTrajectoryKept = 0;
+    unsigned int nbThreads = 1;
+    unsigned int deadline = 0;
+    char isPipelined = 0;
+    FILE* statsFile = NULL;
+    char isCsv = 0;
+    unsigned int step = 0;
 
 #ifdef USE_SDL
     char isDisplayed = 1;
@@ -70,23 +126,33 @@ int main(int argc, char* argv[]) {
     state* nextState = NULL;
     double reward = 0.0;
     action* optimalAction = NULL;
+    action* plannedAction = NULL;       // In the pipelined mode, the action planned for the next step while the last one was applied
+    planning_job job;
+    pthread_t planner;
+    double* keys = NULL;
 
     struct arg_dbl* g = arg_dbl1("g", "discountFactor", "<d>", "The discount factor for the problem");
     struct arg_int* n = arg_int1("n", "nbEvaluations", "<n>", "The number of evaluations");
     struct arg_int* s = arg_int0("s", "nbtimestep", "<n>", "The number of timestep");
     struct arg_int* b = arg_int0("b", "branchingFactor", "<n>", "The branching factor of the problem");
     struct arg_str* i = arg_str0(NULL, "state", "<s>", "The initial state to use");
+    struct arg_int* w = arg_int0(NULL, "seed", "<n>", "The seed of the random numbers, the current time if not given");
+    struct arg_lit* j = arg_lit0(NULL, "trajectories", "Keep the simulated trajectories until the next step instead of their discounted sums only");
+    struct arg_int* t = arg_int0("t", "threads", "<n>", "The number of threads, each simulating its own trajectories");
+    struct arg_int* l = arg_int0(NULL, "deadline", "<n>", "The time in microseconds each step is planned for at most");
+    struct arg_lit* o = arg_lit0(NULL, "pipeline", "Plan each step from the state the last action should lead to while it is applied");
+    struct arg_str* y = arg_str0(NULL, "stats", "<s>", "The file the counters of each planning are written to, as CSV if it ends with .csv, JSON lines else. Needs a build with USE_STATS");
 
 #ifdef USE_SDL
     struct arg_lit* d = arg_lit0("d", NULL, "Display the viewer");
     struct arg_lit* f = arg_lit0("f", NULL, "Fullscreen");
     struct arg_lit* v = arg_lit0("v", NULL, "Verbose");
     struct arg_str* r = arg_str0(NULL, "resolution", "<s>", "The resolution of the display window");
-    void* argtable[10];
-    int nbArgs = 9;
+    void* argtable[16];
+    int nbArgs = 15;
 #else
-    void* argtable[6];
-    int nbArgs = 5;
+    void* argtable[12];
+    int nbArgs = 11;
 #endif
 
     struct arg_end* end = arg_end(nbArgs+1);
@@ -94,14 +160,15 @@ int main(int argc, char* argv[]) {
 
     s->ival[0] = -1;
     b->ival[0] = 0;
+    t->ival[0] = 1;
 
-    argtable[0] = g; argtable[1] = n; argtable[2] = s; argtable[3] = b; argtable[4] = i;
+    argtable[0] = g; argtable[1] = n; argtable[2] = s; argtable[3] = b; argtable[4] = i; argtable[5] = w; argtable[6] = j; argtable[7] = t; argtable[8] = l; argtable[9] = o; argtable[10] = y;
 
 #ifdef USE_SDL
-    argtable[5] = d;
-    argtable[6] = f;
-    argtable[7] = v;
-    argtable[8] = r;
+    argtable[11] = d;
+    argtable[12] = f;
+    argtable[13] = v;
+    argtable[14] = r;
 #endif
 
     argtable[nbArgs] = end;
@@ -122,11 +189,33 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
+    if(y->count) {
+        size_t length = strlen(y->sval[0]);
+
+        if(!STATS_ENABLED) {
+            printf("error: --stats needs a build with USE_STATS\n");
+            arg_freetable(argtable, nbArgs+1);
+            return EXIT_FAILURE;
+        }
+
+        statsFile = fopen(y->sval[0], "w");
+        if(statsFile == NULL) {
+            printf("error: can not open %s\n", y->sval[0]);
+            arg_freetable(argtable, nbArgs+1);
+            return EXIT_FAILURE;
+        }
+
+        isCsv = (length > 4) && (strcmp(y->sval[0] + length - 4, ".csv") == 0);
+        stats_writeHeader(statsFile, isCsv);
+    }
+
     discountFactor = g->dval[0];
     maxNbEvaluations = n->ival[0];
 
     branchingFactor = b->ival[0];
 
+    modelSeed = w->count ? (uint64_t)w->ival[0] : (uint64_t)time(NULL);
+
     initGenerativeModelParameters();
     if(branchingFactor)
         K = branchingFactor;
@@ -145,10 +234,25 @@ int main(int argc, char* argv[]) {
 #endif
 
     nbTimestep = s->ival[0];
+    isTrajectoryKept = j->count;
+    nbThreads = t->ival[0];
+    deadline = l->count ? l->ival[0] : 0;
+    isPipelined = o->count;
 
     arg_freetable(argtable, nbArgs+1);
 
     instance = random_search_initInstance(crtState, discountFactor);
+    random_search_setSeed(instance, modelSeed);
+    random_search_setTrajectoryKept(instance, isTrajectoryKept);
+    random_search_setThreads(instance, nbThreads);
+
+    job.instance = instance;
+    job.maxNbEvaluations = maxNbEvaluations;
+    job.deadline = deadline;
+    job.statsFile = statsFile;
+    job.isCsv = isCsv;
+    if(isPipelined)
+        keys = (double*)malloc(sizeof(double) * 2 * getStateKeyLength());
 
 #ifdef USE_SDL
     if(isDisplayed) {
@@ -159,20 +263,44 @@ int main(int argc, char* argv[]) {
 #endif
 
     do {
-        random_search_resetInstance(instance, crtState);
+        if(plannedAction != NULL) {                                                         // Planned while the last action was applied
+            optimalAction = plannedAction;
+        } else {
+            random_search_resetInstance(instance, crtState);
+            job.step = step;
+            plan(&job);
+            optimalAction = job.optimalAction;
+        }
 
-        optimalAction = random_search_planning(instance, maxNbEvaluations);
+        if(isPipelined) {                                                                   // The next step is planned from the state the action leads to if the model is deterministic
+            nextStateReward(crtState, optimalAction, &nextState, &reward);
+            random_search_resetInstance(instance, nextState);
+            freeState(nextState);
+            job.step = step + 1;
+            pthread_create(&planner, NULL, plan, &job);
+        }
 
         isTerminal = nextStateReward(crtState, optimalAction, &nextState, &reward);
         freeState(crtState);
         crtState = nextState;
 
+        if(isPipelined) {                                                                   // Planned from another state than the one reached, the next step is planned again
+            pthread_join(planner, NULL);
+            plannedAction = isSameState(crtState, instance->initial, keys) ? job.optimalAction : NULL;
+        }
+
         if(verbose) {
             printState(crtState);
             printAction(optimalAction);
             printf("reward: %f depth: %u\n", reward, random_search_getMaxDepth(instance));
+            if(deadline > 0)
+                printf("deadline: %u evaluations\n", instance->realNbEvaluations);
+            if(isPipelined && !isTerminal && (plannedAction == NULL))
+                printf("pipeline: state mispredicted\n");
         }
 
+        step++;
+
 #ifdef USE_SDL
     } while(!isTerminal && (nbTimestep < 0 || --nbTimestep) && !viewer(crtState, optimalAction, reward, instance));
 #else
@@ -181,6 +309,9 @@ int main(int argc, char* argv[]) {
 
     freeState(crtState);
 
+    free(keys);
+    if(statsFile != NULL)
+        fclose(statsFile);
     random_search_uninitInstance(&instance);
 
     freeGenerativeModel();
@@ -38,26 +38,32 @@
 #include <time.h>
 #include <string.h>
 
-#include <gsl/gsl_rng.h>
-
 #include "random_search.h"
 #include "../../problems/generative_model.h"
 
 
 random_search_instance* random_search_initInstance(state* initial, double discountFactor) {
 
-    unsigned int i = 1;
     random_search_instance* instance = (random_search_instance*)malloc(sizeof(random_search_instance));
 
     instance->QValues = NULL;
-    instance->rng = NULL;
+    instance->seed = (uint64_t)time(NULL);
+    instance->nbPlannings = 0;
+    instance->isTrajectoryKept = 0;
     instance->trajectories = NULL;
     instance->initial = NULL;
+    instance->stateSize = getStateSize();
+    instance->threads = NULL;
+    instance->nbThreads = 0;
+    instance->workers = NULL;
+    random_search_setThreads(instance, 1);
 
     instance->gamma = discountFactor;
-    instance->gammaPowers[0] = 1.0;
-    for(;i < RANDOM_SEARCH_MAX_DEPTH; i++)
-        instance->gammaPowers[i] = instance->gammaPowers[i - 1] * discountFactor;
+    instance->discount = discount_getTable(discountFactor);
+    instance->maxDepth = RANDOM_SEARCH_MAX_DEPTH;
+    instance->realNbEvaluations = 0;
+    deadline_init(&instance->clock);
+    stats_init(&instance->stats);
 
     if(initial != NULL)
         random_search_resetInstance(instance, initial);
@@ -67,6 +73,22 @@ random_search_instance* random_search_initInstance(state* initial, double discou
 }
 
 
+/* Allocates a node of a trajectory along with its state. */
+static random_search_node* allocNode(random_search_instance* instance) {
+
+    random_search_node* node = (random_search_node*)malloc(sizeof(random_search_node) + instance->stateSize);
+
+    node->s = (state*)(node + 1);
+    node->reward = 0.0;
+    node->next = NULL;
+    STATS_ADD(&instance->stats, nbAllocations, 1);
+    STATS_ADD(&instance->stats, nbNodes, 1);
+
+    return node;
+
+}
+
+
 static void deleteTrajectories(random_search_instance* instance) {
 
     random_search_trajectory* crtTrajectory = instance->trajectories;
@@ -76,15 +98,28 @@ static void deleteTrajectories(random_search_instance* instance) {
         random_search_trajectory* tmpTrajectory = crtTrajectory->next;
         while(crt != NULL) {
             random_search_node* tmp = crt->next;
-            freeState(crt->s);
             free(crt);
+            STATS_ADD(&instance->stats, nbFrees, 1);
             crt = tmp;
         }
         free(crtTrajectory);
+        STATS_ADD(&instance->stats, nbFrees, 1);
         crtTrajectory = tmpTrajectory;
     }
 
     instance->trajectories = NULL;
+    STATS_SET(&instance->stats, nbNodes, 0);
+
+}
+
+
+/* Starts the streams of the current planning over, one per thread. */
+static void initStreams(random_search_instance* instance) {
+
+    unsigned int i = 0;
+
+    for(; i < instance->nbThreads; i++)
+        rng_initStream(&instance->workers[i].rng, instance->seed, RNG_STREAM(RNG_RANDOM_SEARCH, instance->nbPlannings - 1, i));
 
 }
 
@@ -93,7 +128,6 @@ void random_search_resetInstance(random_search_instance* instance, state* initia
 
     if(instance->QValues == NULL) {
         instance->QValues = (double*)malloc(sizeof(double) * K);
-        instance->rng = gsl_rng_alloc(gsl_rng_mt19937);
     } else {
         if(instance->initial != NULL)
             freeState(instance->initial);
@@ -101,7 +135,8 @@ void random_search_resetInstance(random_search_instance* instance, state* initia
     }
 
     memset(instance->QValues, 0, sizeof(double) * K);
-    gsl_rng_set(instance->rng, time(NULL));
+    instance->nbPlannings++;
+    initStreams(instance);
 
     instance->initial = copyState(initial);
 
@@ -114,61 +149,206 @@ void random_search_resetInstance(random_search_instance* instance, state* initia
 }
 
 
-action* random_search_planning(random_search_instance* instance, unsigned int maxNbEvaluations) {
+/* Simulates a trajectory starting with firstAction, the next actions drawn at random, and keeps it in the list of
+ * trajectories. Returns its discounted sum. */
+static double keepTrajectory(random_search_instance* instance, unsigned int firstAction) {
 
-    while(instance->crtNbEvaluations < maxNbEvaluations) {
-        random_search_trajectory* newTrajectory = (random_search_trajectory*)malloc(sizeof(random_search_trajectory));
-        random_search_node* crtNode = (random_search_node*)malloc(sizeof(random_search_node));
-        random_search_node* prevNode = NULL;
-        state* crt = instance->initial;
-        state* next = NULL;
-        double reward = 0.0;
-        unsigned int firstAction = gsl_rng_uniform_int(instance->rng, K);
-        unsigned int crtDepth = 1;
-        double discountedSum = 0.0;
+    random_search_trajectory* newTrajectory = (random_search_trajectory*)malloc(sizeof(random_search_trajectory));
+    random_search_node* crtNode = allocNode(instance);
+    const double* gammaPowers = discount_getPowers(instance->discount, instance->crtDepthLimit + 1);
+    double reward = 0.0;
+    unsigned int crtDepth = 1;
+    double discountedSum = 0.0;
+
+    STATS_ADD(&instance->stats, nbAllocations, 1);
+    newTrajectory->next = instance->trajectories;
+    instance->trajectories = newTrajectory;
 
-        newTrajectory->next = instance->trajectories;
-        instance->trajectories = newTrajectory;
+    newTrajectory->trajectory = crtNode;
+    memcpy(crtNode->s, instance->initial, instance->stateSize);
 
-        newTrajectory->trajectory = crtNode;
-        crtNode->s = copyState(crt);
-        crtNode->reward = 0.0;
-        crtNode->next = NULL;
+    crtNode->next = allocNode(instance);                                                    // Each step is simulated right into the state of the next node
+    nextStateRewardInto(crtNode->s, actions[firstAction], crtNode->next->s, &discountedSum);
+    instance->crtNbEvaluations++;
 
-        nextStateReward(crt, actions[firstAction], &next, &discountedSum);
+    crtNode = crtNode->next;
+    crtNode->reward = discountedSum;
+
+    while(crtDepth <= instance->crtDepthLimit) {
+        random_search_node* nextNode = allocNode(instance);
+        char isTerminal = nextStateRewardInto(crtNode->s, actions[rng_uniformInt(&instance->workers->rng, K)], nextNode->s, &reward) < 0 ? 1 : 0;
         instance->crtNbEvaluations++;
+        discountedSum += gammaPowers[crtDepth] * reward;
+
+        nextNode->reward = reward;
+        crtNode->next = nextNode;
+        crtNode = nextNode;
+
+        if(isTerminal)
+            break;
+
+        crtDepth++;
+    }
+
+    return discountedSum;
+
+}
+
+
+/* Same as keepTrajectory but only the discounted sum is kept: the trajectory goes back and forth between the two states
+ * of the worker, which draws the actions, and no deeper than depthLimit. The number of evaluations it took is written in
+ * nbEvaluations. */
+static double simulateTrajectory(random_search_instance* instance, random_search_worker* worker, unsigned int firstAction, unsigned int depthLimit, unsigned int* nbEvaluations) {
+
+    const double* gammaPowers = discount_getPowers(instance->discount, depthLimit + 1);
+    double reward = 0.0;
+    unsigned int crtDepth = 1;
+    double discountedSum = 0.0;
+
+    nextStateRewardInto(instance->initial, actions[firstAction], worker->crtState, &discountedSum);
+    *nbEvaluations = 1;
+
+    while(crtDepth <= depthLimit) {
+        state* tmp = NULL;
+        char isTerminal = nextStateRewardInto(worker->crtState, actions[rng_uniformInt(&worker->rng, K)], worker->nextState, &reward) < 0 ? 1 : 0;
+        (*nbEvaluations)++;
+        discountedSum += gammaPowers[crtDepth] * reward;
+
+        tmp = worker->crtState;
+        worker->crtState = worker->nextState;
+        worker->nextState = tmp;
+
+        if(isTerminal)
+            break;
+
+        crtDepth++;
+    }
+
+    return discountedSum;
+
+}
+
+
+/* Depth of the trajectories once nbEvaluations have been done. */
+static unsigned int getDepthLimit(random_search_instance* instance, unsigned int nbEvaluations) {
+
+    unsigned int depthLimit = nbEvaluations > 0 ? (unsigned int)(log(nbEvaluations) / log(1.0/instance->gamma)) : 1;
+
+    if(depthLimit >= instance->maxDepth)
+        depthLimit = instance->maxDepth - 1;
+    if(depthLimit < 1)
+        depthLimit = 1;
+
+    return depthLimit;
+
+}
+
+
+static void atomicMaxDouble(double* x, double value) {
+
+    double crt = 0.0;
+
+    __atomic_load(x, &crt, __ATOMIC_RELAXED);
+
+    while((value > crt) && !__atomic_compare_exchange(x, &crt, &value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+}
+
+
+static void atomicMaxUnsigned(unsigned int* x, unsigned int value) {
+
+    unsigned int crt = __atomic_load_n(x, __ATOMIC_RELAXED);
+
+    while((value > crt) && !__atomic_compare_exchange_n(x, &crt, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+}
+
+
+/* Simulates trajectories as long as the evaluations done by all the threads are under the budget and the deadline is
+ * not over, the depth following the count of all of them. What the thread found is then merged into the instance without
+ * lock. Each thread checks the deadline on its own copy of the clock. */
+static void runWorker(void* data, unsigned int taskId) {
+
+    random_search_instance* instance = (random_search_instance*)data;
+    random_search_worker* worker = instance->workers + taskId;
+    unsigned int nbEvaluations = __atomic_load_n(&instance->crtNbEvaluations, __ATOMIC_RELAXED);
+    deadline_clock clock = instance->clock;
+    unsigned int i = 0;
+
+    memset(worker->QValues, 0, sizeof(double) * K);
+    worker->crtMaxDepth = 0;
+
+    while((nbEvaluations < instance->maxNbEvaluations) && !deadline_isOver(&clock)) {
+        unsigned int firstAction = rng_uniformInt(&worker->rng, K);
+        unsigned int depthLimit = getDepthLimit(instance, nbEvaluations);
+        unsigned int nbTrajectoryEvaluations = 0;
+        double discountedSum = 0.0;
+
+        STATS_TIME(&instance->stats, simulationTime, discountedSum = simulateTrajectory(instance, worker, firstAction, depthLimit, &nbTrajectoryEvaluations));
+        nbEvaluations = __atomic_add_fetch(&instance->crtNbEvaluations, nbTrajectoryEvaluations, __ATOMIC_RELAXED);
+
+        if(depthLimit > worker->crtMaxDepth)
+            worker->crtMaxDepth = depthLimit;
+
+        if(discountedSum > worker->QValues[firstAction])
+            worker->QValues[firstAction] = discountedSum;
+    }
+
+    for(; i < K; i++)
+        atomicMaxDouble(instance->QValues + i, worker->QValues[i]);
 
-        crt = next;
+    atomicMaxUnsigned(&instance->crtMaxDepth, worker->crtMaxDepth);
 
-        prevNode = crtNode;
-        crtNode = (random_search_node*)malloc(sizeof(random_search_node));
-        crtNode->s = copyState(crt);
-        crtNode->reward = discountedSum;
-        crtNode->next = NULL;
-        prevNode->next = crtNode;
+}
 
-        while(crtDepth <= instance->crtDepthLimit) {
-            char isTerminal = nextStateReward(crt, actions[gsl_rng_uniform_int(instance->rng, K)], &next, &reward) < 0 ? 1 : 0;
-            instance->crtNbEvaluations++;
-            discountedSum += instance->gammaPowers[crtDepth] * reward;
 
-            freeState(crt);
-            crt = next;
+/* The threads share the budget. As they do not split it the same way from one run to the next, a planning on several
+ * threads can not be made again from the seed. */
+static action* planningOnThreads(random_search_instance* instance, unsigned int maxNbEvaluations) {
 
-            prevNode = crtNode;
-            crtNode = (random_search_node*)malloc(sizeof(random_search_node));
-            crtNode->s = copyState(crt);
-            crtNode->reward = reward;
-            crtNode->next = NULL;
-            prevNode->next = crtNode;
+    unsigned int i = 0;
 
-            if(isTerminal)
-                break;
+    instance->maxNbEvaluations = maxNbEvaluations;
+    thread_pool_run(instance->threads, runWorker, instance, instance->nbThreads);
 
-            crtDepth++;
+    for(; i < K; i++) {
+        if(instance->QValues[i] > instance->crtOptimalValue) {
+            instance->crtOptimalValue = instance->QValues[i];
+            instance->crtOptimalAction = i;
         }
+    }
+
+    instance->crtDepthLimit = getDepthLimit(instance, instance->crtNbEvaluations);
+
+    return actions[instance->crtOptimalAction];
+
+}
 
-        freeState(crt);
+
+action* random_search_planning(random_search_instance* instance, unsigned int maxNbEvaluations) {
+
+    unsigned int nbEvaluations = instance->crtNbEvaluations;
+
+    if((instance->threads != NULL) && !instance->isTrajectoryKept) {                            // Kept trajectories are only simulated by the first worker
+        action* a = planningOnThreads(instance, maxNbEvaluations);
+
+        instance->realNbEvaluations = instance->crtNbEvaluations - nbEvaluations;
+        STATS_SET(&instance->stats, maxDepth, random_search_getMaxDepth(instance));
+
+        return a;
+    }
+
+    while((instance->crtNbEvaluations < maxNbEvaluations) && !deadline_isOver(&instance->clock)) {
+        unsigned int firstAction = rng_uniformInt(&instance->workers->rng, K);
+        double discountedSum = 0.0;
+
+        if(instance->isTrajectoryKept) {
+            STATS_TIME(&instance->stats, simulationTime, discountedSum = keepTrajectory(instance, firstAction));
+        } else {
+            unsigned int nbEvaluations = 0;
+            STATS_TIME(&instance->stats, simulationTime, discountedSum = simulateTrajectory(instance, instance->workers, firstAction, instance->crtDepthLimit, &nbEvaluations));
+            instance->crtNbEvaluations += nbEvaluations;
+        }
 
         if(instance->crtDepthLimit > instance->crtMaxDepth)
             instance->crtMaxDepth = instance->crtDepthLimit;
@@ -181,20 +361,110 @@ action* random_search_planning(random_search_instance* instance, unsigned int ma
             }
         }
 
-        if(instance->crtDepthLimit < (RANDOM_SEARCH_MAX_DEPTH - 1)) {
-            instance->crtDepthLimit = (unsigned int)(log(instance->crtNbEvaluations) / log(1.0/instance->gamma));
-            if(instance->crtDepthLimit >= RANDOM_SEARCH_MAX_DEPTH)
-                instance->crtDepthLimit = RANDOM_SEARCH_MAX_DEPTH - 1;
-            if(instance->crtDepthLimit < 1)
-                instance->crtDepthLimit = 1;
-        }
+        instance->crtDepthLimit = getDepthLimit(instance, instance->crtNbEvaluations);
     }
 
+    instance->realNbEvaluations = instance->crtNbEvaluations - nbEvaluations;
+    STATS_SET(&instance->stats, maxDepth, random_search_getMaxDepth(instance));
+
     return actions[instance->crtOptimalAction];
 
 }
 
 
+/* Same as random_search_planning, but also stops at deadline, in nanoseconds on the clock of deadline_now, and then
+ * returns the best action found so far. The number of evaluations done is in realNbEvaluations. */
+action* random_search_planningDeadline(random_search_instance* instance, unsigned int maxNbEvaluations, uint64_t deadline) {
+
+    action* a = NULL;
+
+    deadline_start(&instance->clock, deadline);
+    a = random_search_planning(instance, maxNbEvaluations);
+    deadline_start(&instance->clock, 0);
+
+    return a;
+
+}
+
+
+/* The plannings from now on draw their actions from streams of seed, the current one included which starts over. By
+ * default, the seed is the time the instance was initialized at. */
+void random_search_setSeed(random_search_instance* instance, uint64_t seed) {
+
+    instance->seed = seed;
+    instance->nbPlannings = 0;
+
+    if(instance->initial != NULL) {
+        instance->nbPlannings = 1;
+        initStreams(instance);
+    }
+
+}
+
+
+static void freeWorkers(random_search_instance* instance) {
+
+    unsigned int i = 0;
+
+    for(; i < instance->nbThreads; i++) {
+        free(instance->workers[i].crtState);
+        free(instance->workers[i].nextState);
+        free(instance->workers[i].QValues);
+    }
+
+    free(instance->workers);
+    instance->workers = NULL;
+
+}
+
+
+/* The trajectories are simulated on nbThreads threads, each drawing from a stream of its own, if there are more than one.
+ * The streams of the current planning start over. */
+void random_search_setThreads(random_search_instance* instance, unsigned int nbThreads) {
+
+    unsigned int i = 0;
+
+    if(instance->threads != NULL)
+        thread_pool_uninit(&instance->threads);
+
+    if(instance->workers != NULL)
+        freeWorkers(instance);
+
+    instance->nbThreads = nbThreads > 0 ? nbThreads : 1;
+    instance->workers = (random_search_worker*)malloc(sizeof(random_search_worker) * instance->nbThreads);
+
+    for(; i < instance->nbThreads; i++) {
+        instance->workers[i].crtState = (state*)malloc(instance->stateSize);
+        instance->workers[i].nextState = (state*)malloc(instance->stateSize);
+        instance->workers[i].QValues = (double*)malloc(sizeof(double) * K);
+        instance->workers[i].crtMaxDepth = 0;
+    }
+
+    if(instance->nbThreads > 1)
+        instance->threads = thread_pool_init(instance->nbThreads);
+
+    if(instance->initial != NULL)
+        initStreams(instance);
+
+}
+
+
+/* By default, only the discounted sums of the trajectories are kept. */
+void random_search_setTrajectoryKept(random_search_instance* instance, char isTrajectoryKept) {
+
+    instance->isTrajectoryKept = isTrajectoryKept;
+
+}
+
+
+/* The trajectories are no deeper than maxDepth - 1, RANDOM_SEARCH_MAX_DEPTH - 1 by default. */
+void random_search_setMaxDepth(random_search_instance* instance, unsigned int maxDepth) {
+
+    instance->maxDepth = maxDepth > 1 ? maxDepth : 2;
+
+}
+
+
 unsigned int random_search_getMaxDepth(random_search_instance* instance) {
 
     return instance->crtMaxDepth - 1;
@@ -205,9 +475,12 @@ unsigned int random_search_getMaxDepth(random_search_instance* instance) {
 void random_search_uninitInstance(random_search_instance** instance) {
 
     free((*instance)->QValues);
-    gsl_rng_free((*instance)->rng);
     freeState((*instance)->initial);
     deleteTrajectories(*instance);
+    if((*instance)->threads != NULL)
+        thread_pool_uninit(&(*instance)->threads);
+    freeWorkers(*instance);
+    discount_releaseTable(&(*instance)->discount);
 
     free(*instance);
     *instance = NULL;
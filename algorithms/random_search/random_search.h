@@ -35,15 +35,14 @@
 #ifndef RANDOM_SEARCH
 #define RANDOM_SEARCH
 
-#include <gsl/gsl_rng.h>
-
 #include "../../problems/generative_model.h"
+#include "../../problems/rng.h"
+#include "../thread_pool/thread_pool.h"
+#include "../discount/discount.h"
+#include "../deadline/deadline.h"
+#include "../stats/stats.h"
 
-#ifdef LIMITED_DEPTH
-#define RANDOM_SEARCH_MAX_DEPTH 512
-#else
-#define RANDOM_SEARCH_MAX_DEPTH 32768
-#endif
+#define RANDOM_SEARCH_MAX_DEPTH 32768   // Default depth limit of the trajectories
 
 typedef struct random_search_node_struct {
     state* s;
@@ -56,30 +55,57 @@ typedef struct random_search_trajectory_struct {
     struct random_search_trajectory_struct* next;
 }       random_search_trajectory;
 
+/* What a thread draws and simulates its trajectories with. */
+typedef struct {
+    rng_stream rng;                     // The stream of the thread for the current planning
+    state* crtState;                    // The two states a trajectory is simulated through when it is not kept
+    state* nextState;
+    double* QValues;                    // The best discounted sum of the thread for each first action
+    unsigned int crtMaxDepth;
+}       random_search_worker;
+
 typedef struct {
 
     double* QValues;
     state* initial;
+    size_t stateSize;
     double gamma;
-    double gammaPowers[RANDOM_SEARCH_MAX_DEPTH];
+    discount_table* discount;           // Shared by the instances of the same discount factor
+    unsigned int maxDepth;              // The trajectories are no deeper than maxDepth - 1
 
+    char isTrajectoryKept;              // 1 if the simulated trajectories are kept until the next reset, 0 if only their discounted sums are
     random_search_trajectory* trajectories;
 
-    gsl_rng* rng;
+    uint64_t seed;                      // Seed of the streams the actions are drawn from
+    unsigned int nbPlannings;           // Plannings started since the seed was set: each one draws from streams of its own
     unsigned int crtMaxDepth;
 
+    thread_pool* threads;               // Threads simulating trajectories at the same time. NULL if the planning is sequential
+    unsigned int nbThreads;
+    random_search_worker* workers;      // One per thread. The first one is the one of a sequential planning
+    unsigned int maxNbEvaluations;      // The budget of the current parallel planning
+
     unsigned int crtDepthLimit;
     unsigned int crtNbEvaluations;
+    unsigned int realNbEvaluations;     // Evaluations done by the last planning
     double crtOptimalValue;
     unsigned int crtOptimalAction;
 
+    deadline_clock clock;               // Deadline of the planning being done, if it has one
+    stats_counters stats;               // Where the time of the plannings goes, counted when built with USE_STATS
+
 }       random_search_instance;
 
 
 random_search_instance* random_search_initInstance(state* initial, double discountFactor);
 void random_search_resetInstance(random_search_instance* instance, state* initial);
 action* random_search_planning(random_search_instance* instance, unsigned int maxNbEvaluations);
+action* random_search_planningDeadline(random_search_instance* instance, unsigned int maxNbEvaluations, uint64_t deadline);
 void random_search_keepSubtree(random_search_instance* instance);
+void random_search_setSeed(random_search_instance* instance, uint64_t seed);
+void random_search_setTrajectoryKept(random_search_instance* instance, char isTrajectoryKept);
+void random_search_setThreads(random_search_instance* instance, unsigned int nbThreads);
+void random_search_setMaxDepth(random_search_instance* instance, unsigned int maxDepth);
 unsigned int random_search_getMaxDepth(random_search_instance* instance);
 void random_search_uninitInstance(random_search_instance** instance);
 
@@ -0,0 +1,432 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "region.h"
+
+#define ROUND(size) (((size) + (REGION_ALIGNMENT - 1)) & ~((size_t)REGION_ALIGNMENT - 1))
+#define HEADER_SIZE ROUND(sizeof(region_chunk))
+#define DATA(chunk) ((char*)(chunk) + HEADER_SIZE)
+
+
+region_pool* region_initPool() {
+
+    region_pool* pool = (region_pool*)malloc(sizeof(region_pool));
+
+    pool->freeChunks = NULL;
+    pool->reclaimedChunks = NULL;
+    pool->reclaimer = NULL;
+    pool->nbBytes = 0;
+    pool->nbUsedBytes = 0;
+    pool->maxNbBytes = 0;
+
+    return pool;
+
+}
+
+
+/* Once the chunks of the pool reach maxNbBytes, headers included, no chunk is taken from the system anymore and the
+ * allocations which need one fail. 0 for no limit. */
+void region_setPoolLimit(region_pool* pool, size_t maxNbBytes) {
+
+    pool->maxNbBytes = maxNbBytes;
+
+}
+
+
+/* Returns the number of bytes taken from the system by the pool. */
+size_t region_getPoolSize(region_pool* pool) {
+
+    return __atomic_load_n(&pool->nbBytes, __ATOMIC_RELAXED);
+
+}
+
+
+/* Returns 1 if nbBlocks blocks of blockSize bytes, spread over nbRegions empty regions, can be allocated without going
+ * over the limit of the pool, 0 else. */
+char region_hasRoomFor(region_pool* pool, size_t nbBlocks, size_t blockSize, unsigned int nbRegions) {
+
+    size_t nbBlocksPerChunk = REGION_CHUNK_SIZE / ROUND(blockSize);
+    size_t nbNeededBytes = 0;
+
+    if(pool->maxNbBytes == 0)
+        return 1;
+
+    if(nbBlocksPerChunk == 0)                                                       // One oversized chunk per block
+        nbNeededBytes = nbBlocks * (HEADER_SIZE + ROUND(blockSize));
+    else                                                                            // Each region may leave the end of its last chunk unused
+        nbNeededBytes = ((nbBlocks / nbBlocksPerChunk) + nbRegions) * (HEADER_SIZE + REGION_CHUNK_SIZE);
+
+    return (pool->nbUsedBytes + nbNeededBytes) <= pool->maxNbBytes;
+
+}
+
+
+static void freeChunks(region_chunk* crt) {
+
+    while(crt != NULL) {
+        region_chunk* next = crt->next;
+        free(crt);
+        crt = next;
+    }
+
+}
+
+
+void region_uninitPool(region_pool** pool) {
+
+    if((*pool)->reclaimer != NULL)
+        region_flushReclaimer((*pool)->reclaimer);
+
+    freeChunks((*pool)->freeChunks);
+    freeChunks((*pool)->reclaimedChunks);
+
+    free(*pool);
+    *pool = NULL;
+
+}
+
+
+void region_init(region* r, region_pool* pool) {
+
+    r->pool = pool;
+    r->first = NULL;
+    r->last = NULL;
+    r->nbBytes = 0;
+    r->nbChunkBytes = 0;
+
+}
+
+
+/* Returns a released chunk of the pool, NULL if there is none. */
+static region_chunk* recycleChunk(region_pool* pool) {
+
+    region_chunk* chunk = NULL;
+
+    if((pool->freeChunks == NULL) && (__atomic_load_n(&pool->reclaimedChunks, __ATOMIC_RELAXED) != NULL))
+        pool->freeChunks = __atomic_exchange_n(&pool->reclaimedChunks, NULL, __ATOMIC_ACQUIRE);
+
+    chunk = pool->freeChunks;
+    if(chunk != NULL)
+        pool->freeChunks = chunk->next;
+
+    return chunk;
+
+}
+
+
+static char isOverLimit(region_pool* pool, size_t chunkSize) {
+
+    return (pool->maxNbBytes > 0) && ((region_getPoolSize(pool) + HEADER_SIZE + chunkSize) > pool->maxNbBytes);
+
+}
+
+
+static region_chunk* newChunk(region* r, size_t size) {
+
+    region_chunk* chunk = NULL;
+    size_t chunkSize = size > REGION_CHUNK_SIZE ? size : REGION_CHUNK_SIZE;
+
+    if(size <= REGION_CHUNK_SIZE)                                                   // Recycle a chunk before asking the system for one
+        chunk = recycleChunk(r->pool);
+
+    if((chunk == NULL) && (r->pool->reclaimer != NULL) && isOverLimit(r->pool, chunkSize)) {
+        region_flushReclaimer(r->pool->reclaimer);                                  // The chunks of the released regions may not be back yet
+
+        if(size <= REGION_CHUNK_SIZE)
+            chunk = recycleChunk(r->pool);
+    }
+
+    if(chunk == NULL) {
+        if(isOverLimit(r->pool, chunkSize))
+            return NULL;
+
+        chunk = (region_chunk*)malloc(HEADER_SIZE + chunkSize);
+        if(chunk == NULL)
+            return NULL;
+
+        chunk->size = chunkSize;
+        __atomic_add_fetch(&r->pool->nbBytes, HEADER_SIZE + chunkSize, __ATOMIC_RELAXED);
+    }
+
+    chunk->next = NULL;
+    chunk->used = 0;
+
+    if(r->last != NULL)
+        r->last->next = chunk;
+    else
+        r->first = chunk;
+    r->last = chunk;
+
+    r->nbChunkBytes += HEADER_SIZE + chunk->size;
+    r->pool->nbUsedBytes += HEADER_SIZE + chunk->size;
+
+    return chunk;
+
+}
+
+
+/* Returns a block of size bytes carved from the region. It is only given back when the whole region is released. NULL
+ * if the limit of the pool or the system does not leave room for it. */
+void* region_alloc(region* r, size_t size) {
+
+    region_chunk* chunk = r->last;
+    void* block = NULL;
+
+    size = ROUND(size);
+
+    if((chunk == NULL) || ((chunk->used + size) > chunk->size))
+        chunk = newChunk(r, size);
+
+    if(chunk == NULL)
+        return NULL;
+
+    block = DATA(chunk) + chunk->used;
+    chunk->used += size;
+    r->nbBytes += size;
+
+    return block;
+
+}
+
+
+/* Moves every block of src at the end of dst. src is empty afterward. */
+void region_append(region* dst, region* src) {
+
+    if(src->first == NULL)
+        return;
+
+    if(dst->last != NULL)
+        dst->last->next = src->first;
+    else
+        dst->first = src->first;
+
+    dst->last = src->last;
+    dst->nbBytes += src->nbBytes;
+    dst->nbChunkBytes += src->nbChunkBytes;
+
+    src->first = NULL;
+    src->last = NULL;
+    src->nbBytes = 0;
+    src->nbChunkBytes = 0;
+
+}
+
+
+/* The mutex of the reclaimer is taken by the caller. */
+static void pushEntry(region_reclaimer* reclaimer, region_chunk* first, region_pool* pool) {
+
+    while(sem_wait(&reclaimer->nbFreeEntries) != 0);                                  // Waits for the reclaimer if it is too late
+
+    reclaimer->ring[reclaimer->tail % REGION_RECLAIMER_SIZE].first = first;
+    reclaimer->ring[reclaimer->tail % REGION_RECLAIMER_SIZE].pool = pool;
+    reclaimer->tail++;
+
+    sem_post(&reclaimer->nbEntries);
+
+}
+
+
+/* Gives every chunk back to the pool (oversized ones to the system). The region is empty afterward. If the pool has a
+ * reclaimer, this is done later by it and the release itself does not depend on the size of the region. */
+void region_release(region* r) {
+
+    region_chunk* crt = r->first;
+
+    r->pool->nbUsedBytes -= r->nbChunkBytes;
+
+    if((r->pool->reclaimer != NULL) && (crt != NULL)) {
+        pthread_mutex_lock(&r->pool->reclaimer->mutex);
+        pushEntry(r->pool->reclaimer, crt, r->pool);
+        pthread_mutex_unlock(&r->pool->reclaimer->mutex);
+        crt = NULL;
+    }
+
+    while(crt != NULL) {
+        region_chunk* next = crt->next;
+
+        if(crt->size == REGION_CHUNK_SIZE) {
+            crt->next = r->pool->freeChunks;
+            r->pool->freeChunks = crt;
+        } else {
+            __atomic_sub_fetch(&r->pool->nbBytes, HEADER_SIZE + crt->size, __ATOMIC_RELAXED);
+            free(crt);
+        }
+
+        crt = next;
+    }
+
+    r->first = NULL;
+    r->last = NULL;
+    r->nbBytes = 0;
+    r->nbChunkBytes = 0;
+
+}
+
+
+size_t region_getSize(region* r) {
+
+    return r->nbBytes;
+
+}
+
+
+/* Frees the oversized chunks of a released region and gives the others back to its pool in one go. */
+static void reclaim(region_chunk* crt, region_pool* pool) {
+
+    region_chunk* first = NULL;
+    region_chunk* last = NULL;
+
+    while(crt != NULL) {
+        region_chunk* next = crt->next;
+
+        if(crt->size == REGION_CHUNK_SIZE) {
+            crt->next = first;
+            first = crt;
+            if(last == NULL)
+                last = crt;
+        } else {
+            __atomic_sub_fetch(&pool->nbBytes, HEADER_SIZE + crt->size, __ATOMIC_RELAXED);
+            free(crt);
+        }
+
+        crt = next;
+    }
+
+    if(first != NULL) {
+        region_chunk* reclaimedChunks = __atomic_load_n(&pool->reclaimedChunks, __ATOMIC_RELAXED);
+
+        do {
+            last->next = reclaimedChunks;
+        } while(!__atomic_compare_exchange_n(&pool->reclaimedChunks, &reclaimedChunks, first, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+
+}
+
+
+static void* runReclaimer(void* arg) {
+
+    region_reclaimer* reclaimer = (region_reclaimer*)arg;
+
+    while(1) {
+        region_reclaimed entry;
+
+        while(sem_wait(&reclaimer->nbEntries) != 0);
+
+        entry = reclaimer->ring[reclaimer->head % REGION_RECLAIMER_SIZE];
+        reclaimer->head++;
+        sem_post(&reclaimer->nbFreeEntries);
+
+        if(entry.first != NULL) {
+            reclaim(entry.first, entry.pool);
+        } else {
+            char isStopped = reclaimer->isStopped;
+
+            sem_post(&reclaimer->flushed);
+
+            if(isStopped)
+                break;
+        }
+    }
+
+    return NULL;
+
+}
+
+
+region_reclaimer* region_initReclaimer() {
+
+    region_reclaimer* reclaimer = (region_reclaimer*)malloc(sizeof(region_reclaimer));
+
+    reclaimer->head = 0;
+    reclaimer->tail = 0;
+    sem_init(&reclaimer->nbEntries, 0, 0);
+    sem_init(&reclaimer->nbFreeEntries, 0, REGION_RECLAIMER_SIZE);
+    sem_init(&reclaimer->flushed, 0, 0);
+    reclaimer->isStopped = 0;
+    pthread_mutex_init(&reclaimer->mutex, NULL);
+
+    pthread_create(&reclaimer->thread, NULL, runReclaimer, reclaimer);
+
+    return reclaimer;
+
+}
+
+
+/* The regions of the pool are released by the reclaimer if it is not NULL, by the releasing thread else. */
+void region_setReclaimer(region_pool* pool, region_reclaimer* reclaimer) {
+
+    if(pool->reclaimer != NULL)
+        region_flushReclaimer(pool->reclaimer);
+
+    pool->reclaimer = reclaimer;
+
+}
+
+
+/* Returns once every region released so far has been reclaimed. */
+void region_flushReclaimer(region_reclaimer* reclaimer) {
+
+    pthread_mutex_lock(&reclaimer->mutex);
+
+    pushEntry(reclaimer, NULL, NULL);
+
+    while(sem_wait(&reclaimer->flushed) != 0);
+
+    pthread_mutex_unlock(&reclaimer->mutex);
+
+}
+
+
+/* Every pool using the reclaimer has to be uninitialized or set without reclaimer before. */
+void region_uninitReclaimer(region_reclaimer** reclaimer) {
+
+    (*reclaimer)->isStopped = 1;
+    region_flushReclaimer(*reclaimer);
+    pthread_join((*reclaimer)->thread, NULL);
+
+    pthread_mutex_destroy(&(*reclaimer)->mutex);
+    sem_destroy(&(*reclaimer)->flushed);
+    sem_destroy(&(*reclaimer)->nbFreeEntries);
+    sem_destroy(&(*reclaimer)->nbEntries);
+
+    free(*reclaimer);
+    *reclaimer = NULL;
+
+}
@@ -0,0 +1,106 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef REGION_H
+#define REGION_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#define REGION_CHUNK_SIZE 1048576                   // Size of the chunks recycled through a pool
+#define REGION_ALIGNMENT 16                         // Every block handed out is aligned on this
+#define REGION_RECLAIMER_SIZE 64                    // Number of released regions a reclaimer can be late of before the releases wait for it
+
+typedef struct region_chunk_struct {
+        struct region_chunk_struct* next;           // Next chunk of the region (or of the pool)
+        size_t size;                                // Number of usable bytes in this chunk
+        size_t used;                                // Number of bytes already handed out
+}   region_chunk;
+
+typedef struct {
+        region_chunk* freeChunks;                   // Released chunks waiting to be reused
+        region_chunk* reclaimedChunks;              // Chunks given back by the reclaimer, taken all at once when there is no free chunk left
+        struct region_reclaimer_struct* reclaimer;  // Where the regions are released if not NULL
+        size_t nbBytes;                             // Bytes of the chunks taken from the system and not given back yet, headers included
+        size_t nbUsedBytes;                         // Bytes of the chunks in the regions of the pool, headers included
+        size_t maxNbBytes;                          // Bound on nbBytes. 0 if there is none
+}   region_pool;
+
+typedef struct {
+        region_pool* pool;                          // Where chunks come from and go back to
+        region_chunk* first;                        // First chunk of the region. NULL if the region is empty
+        region_chunk* last;                         // Chunk in which the next block is carved
+        size_t nbBytes;                             // Number of bytes handed out by this region
+        size_t nbChunkBytes;                        // Bytes of the chunks of this region, headers included
+}   region;
+
+typedef struct {
+        region_chunk* first;                        // The chunks of a released region. NULL to ask for a flush
+        region_pool* pool;                          // The pool they go back to
+}   region_reclaimed;
+
+/* A thread giving the chunks of released regions back to their pools. The regions are passed through a ring which is
+ * emptied without lock by the reclaimer and filled under a mutex, so that the pools using it can be released from
+ * several threads. */
+typedef struct region_reclaimer_struct {
+        region_reclaimed ring[REGION_RECLAIMER_SIZE];
+        unsigned int head;                          // Next entry to be reclaimed. Only written by the reclaimer
+        unsigned int tail;                          // Next entry to be filled. Only written by the releasing thread
+        sem_t nbEntries;                            // Entries waiting in the ring
+        sem_t nbFreeEntries;                        // Room left in the ring: waiting on it is the backpressure on the releases
+        sem_t flushed;                              // Posted when a flush entry is reached
+        char isStopped;                             // 1 if the reclaimer has to stop after the next flush, 0 else
+        pthread_mutex_t mutex;                      // Taken to fill the ring, and by a flush until it is done
+        pthread_t thread;
+}   region_reclaimer;
+
+region_pool* region_initPool();
+void region_setPoolLimit(region_pool* pool, size_t maxNbBytes);
+size_t region_getPoolSize(region_pool* pool);
+char region_hasRoomFor(region_pool* pool, size_t nbBlocks, size_t blockSize, unsigned int nbRegions);
+void region_uninitPool(region_pool** pool);
+
+void region_init(region* r, region_pool* pool);
+void* region_alloc(region* r, size_t size);
+void region_append(region* dst, region* src);
+void region_release(region* r);
+size_t region_getSize(region* r);
+
+region_reclaimer* region_initReclaimer();
+void region_setReclaimer(region_pool* pool, region_reclaimer* reclaimer);
+void region_flushReclaimer(region_reclaimer* reclaimer);
+void region_uninitReclaimer(region_reclaimer** reclaimer);
+
+#endif
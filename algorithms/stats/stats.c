@@ -0,0 +1,104 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include <string.h>
+
+#include "stats.h"
+
+
+void stats_init(stats_counters* stats) {
+
+    memset(stats, 0, sizeof(stats_counters));
+
+}
+
+
+/* Starts the counts of a new step over. The size of the tree is left as it is. */
+void stats_reset(stats_counters* stats) {
+
+    stats->simulationTime = 0;
+    stats->bookkeepingTime = 0;
+    stats->keepSubtreeTime = 0;
+    stats->updateValuesTime = 0;
+    stats->nbAllocations = 0;
+    stats->nbFrees = 0;
+
+}
+
+
+/* Adds the counts of other, another tree of the same planning, to stats, and starts them over. */
+void stats_merge(stats_counters* stats, stats_counters* other) {
+
+    stats->simulationTime += other->simulationTime;
+    stats->bookkeepingTime += other->bookkeepingTime;
+    stats->keepSubtreeTime += other->keepSubtreeTime;
+    stats->updateValuesTime += other->updateValuesTime;
+    stats->nbAllocations += other->nbAllocations;
+    stats->nbFrees += other->nbFrees;
+    stats->nbNodes += other->nbNodes;
+
+    if(other->maxDepth > stats->maxDepth)
+        stats->maxDepth = other->maxDepth;
+
+    stats_reset(other);
+
+}
+
+
+/* The CSV needs a header, the JSON lines do not. */
+void stats_writeHeader(FILE* file, char isCsv) {
+
+    if(isCsv)
+        fprintf(file, "step,nbEvaluations,planningTime,simulationTime,bookkeepingTime,keepSubtreeTime,updateValuesTime,nbAllocations,nbFrees,nbNodes,maxDepth\n");
+
+}
+
+
+/* Writes the counters of a step as a line of CSV or a JSON object on one line. planningTime is the time in nanoseconds
+ * the step was planned for, as seen from outside the planner. */
+void stats_write(FILE* file, char isCsv, unsigned int step, unsigned int nbEvaluations, uint64_t planningTime, stats_counters* stats) {
+
+    if(isCsv)
+        fprintf(file, "%u,%u,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%u\n", step, nbEvaluations, (unsigned long long)planningTime,
+                (unsigned long long)stats->simulationTime, (unsigned long long)stats->bookkeepingTime, (unsigned long long)stats->keepSubtreeTime,
+                (unsigned long long)stats->updateValuesTime, (unsigned long long)stats->nbAllocations, (unsigned long long)stats->nbFrees,
+                (unsigned long long)stats->nbNodes, stats->maxDepth);
+    else
+        fprintf(file, "{\"step\": %u, \"nbEvaluations\": %u, \"planningTime\": %llu, \"simulationTime\": %llu, \"bookkeepingTime\": %llu, \"keepSubtreeTime\": %llu, \"updateValuesTime\": %llu, \"nbAllocations\": %llu, \"nbFrees\": %llu, \"nbNodes\": %llu, \"maxDepth\": %u}\n",
+                step, nbEvaluations, (unsigned long long)planningTime,
+                (unsigned long long)stats->simulationTime, (unsigned long long)stats->bookkeepingTime, (unsigned long long)stats->keepSubtreeTime,
+                (unsigned long long)stats->updateValuesTime, (unsigned long long)stats->nbAllocations, (unsigned long long)stats->nbFrees,
+                (unsigned long long)stats->nbNodes, stats->maxDepth);
+
+}
@@ -0,0 +1,77 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../deadline/deadline.h"
+
+/* Where the time and the memory of the plannings of an instance go. The counters are only updated when built with
+ * USE_STATS: else the macros below are empty and the counters stay at 0. The times are in nanoseconds, summed over the
+ * threads, and the counters are updated atomically so that the threads of a planning can share them. */
+typedef struct {
+        uint64_t simulationTime;            // In the generative model and the transposition table
+        uint64_t bookkeepingTime;           // Setting the values of the new nodes and passing them up the tree
+        uint64_t keepSubtreeTime;           // In keepSubtree, updateValuesTime included
+        uint64_t updateValuesTime;          // Rebasing the values of the tree on the root
+        uint64_t nbAllocations;             // Blocks taken from the heap or from a region
+        uint64_t nbFrees;                   // Blocks given back, a region released at once counting as one
+        uint64_t nbNodes;                   // Nodes of the tree, or of the kept trajectories, at the end of the last planning
+        unsigned int maxDepth;              // Depth of the deepest of them
+}   stats_counters;
+
+#ifdef USE_STATS
+    #define STATS_ENABLED 1
+    #define STATS_TIME(stats, counter, statement) do { uint64_t statsStart = deadline_now(); statement; __atomic_add_fetch(&(stats)->counter, deadline_now() - statsStart, __ATOMIC_RELAXED); } while(0)
+    #define STATS_ADD(stats, counter, n) __atomic_add_fetch(&(stats)->counter, (n), __ATOMIC_RELAXED)
+    #define STATS_SET(stats, counter, value) ((stats)->counter = (value))
+    #define STATS_MERGE(stats, other) stats_merge((stats), (other))
+#else
+    #define STATS_ENABLED 0
+    #define STATS_TIME(stats, counter, statement) do { statement; } while(0)
+    #define STATS_ADD(stats, counter, n) ((void)(stats))
+    #define STATS_SET(stats, counter, value) ((void)(stats))
+    #define STATS_MERGE(stats, other) ((void)(stats), (void)(other))
+#endif
+
+void stats_init(stats_counters* stats);
+void stats_reset(stats_counters* stats);
+void stats_merge(stats_counters* stats, stats_counters* other);
+void stats_writeHeader(FILE* file, char isCsv);
+void stats_write(FILE* file, char isCsv, unsigned int step, unsigned int nbEvaluations, uint64_t planningTime, stats_counters* stats);
+
+#endif
@@ -0,0 +1,168 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "thread_pool.h"
+
+
+/* Runs the tasks of the current batch until none is left. The mutex is held when called and when returning. */
+static void runTasks(thread_pool* pool) {
+
+    while(pool->nextTask < pool->nbTasks) {
+        unsigned int taskId = pool->nextTask++;
+
+        pthread_mutex_unlock(&pool->mutex);
+        pool->task(pool->data, taskId);
+        pthread_mutex_lock(&pool->mutex);
+
+        pool->nbDoneTasks++;
+        if(pool->nbDoneTasks == pool->nbTasks)
+            pthread_cond_signal(&pool->batchDone);
+    }
+
+}
+
+
+static void* worker(void* arg) {
+
+    thread_pool* pool = (thread_pool*)arg;
+    unsigned int batchId = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while(1) {
+        while((pool->batchId == batchId) && !pool->isStopped)
+            pthread_cond_wait(&pool->newBatch, &pool->mutex);
+
+        if(pool->isStopped)
+            break;
+
+        batchId = pool->batchId;
+        runTasks(pool);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+
+}
+
+
+/* Starts nbThreads - 1 workers: the thread calling thread_pool_run is the last one. */
+thread_pool* thread_pool_init(unsigned int nbThreads) {
+
+    thread_pool* pool = (thread_pool*)malloc(sizeof(thread_pool));
+    unsigned int i = 0;
+
+    pool->nbThreads = nbThreads > 0 ? nbThreads : 1;
+    pool->workers = (pthread_t*)malloc(sizeof(pthread_t) * pool->nbThreads);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->newBatch, NULL);
+    pthread_cond_init(&pool->batchDone, NULL);
+    pool->task = NULL;
+    pool->data = NULL;
+    pool->nbTasks = 0;
+    pool->nextTask = 0;
+    pool->nbDoneTasks = 0;
+    pool->batchId = 0;
+    pool->isStopped = 0;
+
+    for(; i < (pool->nbThreads - 1); i++)
+        pthread_create(pool->workers + i, NULL, worker, pool);
+
+    return pool;
+
+}
+
+
+/* Runs the nbTasks tasks of a batch on the threads of the pool and returns once all of them are done. Which thread
+ * runs which task is up to the scheduling: a task should only write what belongs to its index. */
+void thread_pool_run(thread_pool* pool, thread_pool_task task, void* data, unsigned int nbTasks) {
+
+    unsigned int i = 0;
+
+    if(nbTasks == 0)
+        return;
+
+    if(pool->nbThreads == 1) {
+        for(; i < nbTasks; i++)
+            task(data, i);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+
+    pool->task = task;
+    pool->data = data;
+    pool->nbTasks = nbTasks;
+    pool->nextTask = 0;
+    pool->nbDoneTasks = 0;
+    pool->batchId++;
+    pthread_cond_broadcast(&pool->newBatch);
+
+    runTasks(pool);
+
+    while(pool->nbDoneTasks < pool->nbTasks)
+        pthread_cond_wait(&pool->batchDone, &pool->mutex);
+
+    pthread_mutex_unlock(&pool->mutex);
+
+}
+
+
+void thread_pool_uninit(thread_pool** pool) {
+
+    unsigned int i = 0;
+
+    pthread_mutex_lock(&(*pool)->mutex);
+    (*pool)->isStopped = 1;
+    pthread_cond_broadcast(&(*pool)->newBatch);
+    pthread_mutex_unlock(&(*pool)->mutex);
+
+    for(; i < ((*pool)->nbThreads - 1); i++)
+        pthread_join((*pool)->workers[i], NULL);
+
+    pthread_cond_destroy(&(*pool)->batchDone);
+    pthread_cond_destroy(&(*pool)->newBatch);
+    pthread_mutex_destroy(&(*pool)->mutex);
+    free((*pool)->workers);
+
+    free(*pool);
+    *pool = NULL;
+
+}
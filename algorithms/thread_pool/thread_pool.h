@@ -0,0 +1,62 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+
+/* A task of a batch, called with the data of the batch and the index of the task in it. */
+typedef void (*thread_pool_task)(void* data, unsigned int taskId);
+
+typedef struct {
+        unsigned int nbThreads;                     // Number of threads running the tasks, the one calling thread_pool_run included
+        pthread_t* workers;                         // The nbThreads - 1 other threads
+        pthread_mutex_t mutex;
+        pthread_cond_t newBatch;                    // Signaled when a batch is given or when the workers have to stop
+        pthread_cond_t batchDone;                   // Signaled when the last task of a batch is done
+        thread_pool_task task;                      // The task of the current batch
+        void* data;                                 // The data of the current batch
+        unsigned int nbTasks;                       // Number of tasks of the current batch
+        unsigned int nextTask;                      // Index of the next task to be taken
+        unsigned int nbDoneTasks;
+        unsigned int batchId;                       // Incremented for each batch so that the workers can tell a new one
+        char isStopped;                             // 1 if the workers have to stop, 0 else
+}   thread_pool;
+
+thread_pool* thread_pool_init(unsigned int nbThreads);
+void thread_pool_run(thread_pool* pool, thread_pool_task task, void* data, unsigned int nbTasks);
+void thread_pool_uninit(thread_pool** pool);
+
+#endif
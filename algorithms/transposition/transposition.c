@@ -0,0 +1,177 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "transposition.h"
+
+#define ALIGN(size) (((size) + (sizeof(double) - 1)) & ~(sizeof(double) - 1))
+
+/* Layout of an entry. A hash of 0 marks an empty slot. */
+#define HASH(entry) (*(uint64_t*)(entry))
+#define KEY(entry) ((double*)((entry) + sizeof(uint64_t)))
+#define REWARDS(table, entry) (KEY(entry) + (table)->keyLength)
+#define STATES(table, entry) ((char*)(REWARDS(table, entry) + K))
+#define RESULTS(table, entry) (STATES(table, entry) + (K * (table)->stateSize))
+
+
+/* The table takes as many slots as fit in maxNbBytes, up to a power of 2. */
+transposition_table* transposition_initTable(size_t maxNbBytes, double quantum) {
+
+    transposition_table* table = (transposition_table*)malloc(sizeof(transposition_table));
+
+    table->quantum = quantum;
+    table->keyLength = getStateKeyLength();
+    table->stateSize = getStateSize();
+    table->entrySize = ALIGN(sizeof(uint64_t) + ((table->keyLength + K) * sizeof(double)) + (K * table->stateSize) + K);
+
+    table->nbSlots = 1;
+    while((2 * table->nbSlots * table->entrySize) <= maxNbBytes)
+        table->nbSlots *= 2;
+
+    table->nbEntries = 0;
+    table->maxNbEntries = (3 * table->nbSlots) / 4;
+    table->slots = (char*)calloc(table->nbSlots, table->entrySize);                        // Only the pages of the slots in use are touched
+    table->nbLookups = 0;
+    table->nbHits = 0;
+
+    return table;
+
+}
+
+
+/* FNV-1a on the bytes of the key. Never 0 as it would mark an empty slot. */
+static uint64_t hashKey(double* key, unsigned int keyLength) {
+
+    unsigned char* bytes = (unsigned char*)key;
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i = 0;
+
+    for(; i < (keyLength * sizeof(double)); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash == 0 ? 1 : hash;
+
+}
+
+
+/* Returns the entry with this key, or the empty slot where it would be added. There is always one as the table is
+ * never filled. */
+static char* findEntry(transposition_table* table, double* key, uint64_t hash) {
+
+    size_t mask = table->nbSlots - 1;
+    size_t i = hash & mask;
+
+    while(1) {
+        char* entry = table->slots + (i * table->entrySize);
+
+        if(HASH(entry) == 0)
+            return entry;
+
+        if((HASH(entry) == hash) && (memcmp(KEY(entry), key, table->keyLength * sizeof(double)) == 0))
+            return entry;
+
+        i = (i + 1) & mask;
+    }
+
+}
+
+
+/* If s is in the table, writes what nextStatesRewardsInto would for it and returns 1, else returns 0. Lookups can be
+ * done by several threads at once, but not while a state is added. */
+char transposition_lookup(transposition_table* table, state* s, state* nextStates, double* rewards, char* results) {
+
+    double key[table->keyLength];
+    uint64_t hash = 0;
+    char* entry = NULL;
+
+    getStateKey(s, table->quantum, key);
+    hash = hashKey(key, table->keyLength);
+    entry = findEntry(table, key, hash);
+
+    __atomic_add_fetch(&table->nbLookups, 1, __ATOMIC_RELAXED);
+
+    if(HASH(entry) == 0)
+        return 0;
+
+    __atomic_add_fetch(&table->nbHits, 1, __ATOMIC_RELAXED);
+
+    memcpy(rewards, REWARDS(table, entry), K * sizeof(double));
+    memcpy(nextStates, STATES(table, entry), K * table->stateSize);
+    memcpy(results, RESULTS(table, entry), K);
+
+    return 1;
+
+}
+
+
+/* Adds what nextStatesRewardsInto wrote for s, unless s is already in the table or the table is full. */
+void transposition_insert(transposition_table* table, state* s, state* nextStates, double* rewards, char* results) {
+
+    double key[table->keyLength];
+    uint64_t hash = 0;
+    char* entry = NULL;
+
+    if(table->nbEntries >= table->maxNbEntries)
+        return;
+
+    getStateKey(s, table->quantum, key);
+    hash = hashKey(key, table->keyLength);
+    entry = findEntry(table, key, hash);
+
+    if(HASH(entry) != 0)
+        return;
+
+    memcpy(KEY(entry), key, table->keyLength * sizeof(double));
+    memcpy(REWARDS(table, entry), rewards, K * sizeof(double));
+    memcpy(STATES(table, entry), nextStates, K * table->stateSize);
+    memcpy(RESULTS(table, entry), results, K);
+    HASH(entry) = hash;
+
+    table->nbEntries++;
+
+}
+
+
+void transposition_uninitTable(transposition_table** table) {
+
+    free((*table)->slots);
+    free(*table);
+    *table = NULL;
+
+}
@@ -0,0 +1,66 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../problems/generative_model.h"
+
+/* The K next states, rewards and results of the states already simulated, so that a state reached again, by another
+ * sequence of actions or at another depth, is not simulated again. Only what does not depend on where the state is in
+ * the tree is kept: the discounted sums are still computed by each node from its own depth. The table is an open
+ * addressing one of fixed size: once it is full, the new states are simulated but not added anymore. */
+typedef struct {
+        double quantum;                             // The states are quantized by it before being compared. 0 to compare them exactly
+        unsigned int keyLength;                     // Number of doubles in the key of a state
+        size_t stateSize;                           // Size of a state of the generative model
+        size_t entrySize;                           // Hash, key, K rewards, K next states and K results, padded to keep the next entry aligned
+        size_t nbSlots;                             // A power of 2
+        size_t nbEntries;
+        size_t maxNbEntries;                        // Three quarters of the slots so that the probes stay short
+        char* slots;
+        size_t nbLookups;                           // Counted atomically as the lookups can be done by several threads at once
+        size_t nbHits;
+}   transposition_table;
+
+transposition_table* transposition_initTable(size_t maxNbBytes, double quantum);
+char transposition_lookup(transposition_table* table, state* s, state* nextStates, double* rewards, char* results);
+void transposition_insert(transposition_table* table, state* s, state* nextStates, double* rewards, char* results);
+void transposition_uninitTable(transposition_table** table);
+
+#endif
@@ -1,25 +1,37 @@
 CC_OPTIONS := -O3
 USE_SDL := 1
 CC := gcc
-FLAGS := -W -Wall $(CC_OPTIONS) -ansi -std=c99 -pedantic -Werror$(if $(USE_SDL), -DUSE_SDL)
-LIBS := -lm$(if $(USE_SDL), -lSDL -lSDLmain /usr/lib/libSDL_gfx.so) -largtable2 -lgsl -lgslcblas
+FLAGS := -W -Wall $(CC_OPTIONS) -ansi -std=c99 -pedantic -Werror$(if $(USE_SDL), -DUSE_SDL)$(if $(USE_STATS), -DUSE_STATS)
+LIBS := -lm -lpthread$(if $(USE_SDL), -lSDL -lSDLmain /usr/lib/libSDL_gfx.so) -largtable2
 BIN_DIR := ../bin
 OBJ_DIR := ../obj
 
-all: $(addprefix $(BIN_DIR)/uct_,$(PROBLEMS)) $(OBJ_DIR)/uct_limited.o 
+all: $(addprefix $(BIN_DIR)/uct_,$(PROBLEMS))
 
-$(OBJ_DIR)/uct.o: uct/uct.c uct/uct.h
+$(OBJ_DIR)/region.o: region/region.c region/region.h
 	$(CC) -c $(FLAGS) $< -o $@
 
-$(OBJ_DIR)/uct_limited.o: uct/uct.c uct/uct.h
-	$(CC) -c $(FLAGS) -DLIMITED_DEPTH $< -o $@
+$(OBJ_DIR)/thread_pool.o: thread_pool/thread_pool.c thread_pool/thread_pool.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/discount.o: discount/discount.c discount/discount.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/deadline.o: deadline/deadline.c deadline/deadline.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/stats.o: stats/stats.c stats/stats.h deadline/deadline.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/uct.o: uct/uct.c uct/uct.h uct/uct_kernel.h kernel/kernel.h region/region.h thread_pool/thread_pool.h discount/discount.h deadline/deadline.h stats/stats.h
+	$(CC) -c $(FLAGS) $< -o $@
 
-$(OBJ_DIR)/uct_drawing.o: uct/uct_drawing.c uct/uct_drawing.h uct/uct.h
+$(OBJ_DIR)/uct_drawing.o: uct/uct_drawing.c uct/uct_drawing.h uct/uct.h thread_pool/thread_pool.h discount/discount.h deadline/deadline.h stats/stats.h
 	$(CC) -c $(FLAGS) $< -o $@
 
 $(OBJ_DIR)/main_uct.o: uct/main_uct.c
 	$(CC) -c $(FLAGS) $< -o $@
 
 .SECONDEXPANSION:
-$(BIN_DIR)/uct_%: $(OBJ_DIR)/uct.o $(OBJ_DIR)/main_uct.o $(OBJ_DIR)/$$*.o $(if $(USE_SDL),$(OBJ_DIR)/uct_drawing.o) $$(if $(USE_SDL),$(OBJ_DIR)/viewer_$$*.o)
+$(BIN_DIR)/uct_%: $(OBJ_DIR)/uct.o $(OBJ_DIR)/region.o $(OBJ_DIR)/thread_pool.o $(OBJ_DIR)/discount.o $(OBJ_DIR)/deadline.o $(OBJ_DIR)/stats.o $(OBJ_DIR)/main_uct.o $(OBJ_DIR)/$$*.o $(if $(USE_SDL),$(OBJ_DIR)/uct_drawing.o) $$(if $(USE_SDL),$(OBJ_DIR)/viewer_$$*.o)
 	$(CC) $(FLAGS) $(LIBS) $^ -o $@
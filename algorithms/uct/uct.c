@@ -40,25 +40,64 @@
 #include "uct.h"
 #include "../../problems/generative_model.h"
 
+#define MIN_ROOT_GAMMA_POWER 1e-3       // Below, the values are rebased on the root before they lose too much precision
+
+/* The functions looping over the children of a node, compiled for the branching factors of ../kernel/kernel.h. */
+typedef struct {
+        void (*updateNode)(uct_instance* instance, uct_node* n);
+        void (*updateAncestors)(uct_instance* instance, uct_node* n);
+        unsigned int (*getBestChild)(uct_instance* instance, uct_node* n, uct_node* children);
+        void (*refreshNode)(uct_instance* instance, uct_node* n);
+}   uct_kernel;
+
+#define KERNEL_FILE "../uct/uct_kernel.h"
+#include "../kernel/kernel.h"
+
+static const uct_kernel* crtKernel = &kernelGeneric;                                        // The functions compiled for K, chosen at the initialization of an instance
+
+
 uct_instance* uct_initInstance(state* initial, double discountFactor) {
 
     uct_instance* instance = (uct_instance*)malloc(sizeof(uct_instance));
-    unsigned int i = 1;
+    unsigned int i = 0;
 
     memset(instance, 0xda, sizeof(uct_instance));
 
-    instance->gammaPowers[0] = 1.0;
-    instance->bounds[0] = 1.0 / (1.0 - discountFactor);
-
-    for(; i < UCT_MAX_DEPTH; i++) {
-        instance->gammaPowers[i] = instance->gammaPowers[i - 1] * discountFactor;
-        instance->bounds[i] = instance->gammaPowers[i] / (1.0 - discountFactor);
-    }
+    crtKernel = KERNEL_SELECT(kernel);
 
     instance->gamma = discountFactor;
+    instance->discount = discount_getTable(discountFactor);
+    instance->explorationFactor = 1.0;
+    instance->maxDepth = UCT_MAX_DEPTH;
     instance->root = NULL;
     instance->totalNbEvaluations = 0;
 
+    instance->stateSize = getStateSize();
+    instance->childrenSize = K * (sizeof(uct_node) + instance->stateSize);
+    instance->rewards = (double*)malloc(sizeof(double) * K);
+    instance->results = (char*)malloc(sizeof(char) * K);
+
+    instance->pool = region_initPool();
+    instance->regions = (region*)malloc(sizeof(region) * (K + 1));
+
+    for(i = 0; i <= K; i++)
+        region_init(instance->regions + i, instance->pool);
+    region_init(&instance->oldRegion, instance->pool);
+
+    instance->nbThreads = 1;
+    instance->threads = NULL;
+    instance->isTreeShared = 0;
+    instance->nbWorkers = 0;
+    instance->workers = NULL;
+
+    instance->maxNbBytes = 0;
+    instance->isPruningUsed = 0;
+    instance->isMemoryFull = 0;
+    instance->nbPrunedSubtrees = 0;
+
+    deadline_init(&instance->clock);
+    stats_init(&instance->stats);
+
     if(initial != NULL)
         uct_resetInstance(instance, initial);
 
@@ -66,43 +105,64 @@ uct_instance* uct_initInstance(state* initial, double discountFactor) {
 
 }
 
-static void deleteTree(uct_node *n) {
+/* Points the K children to their states, which follow them in the same block. */
+static void setStates(uct_instance* instance, uct_node* children) {
 
-    if(n->children == NULL) {
-        freeState(n->s);
-        return;
-    }
+    char* states = (char*)(children + K);
+    unsigned int i = 0;
 
-    uct_node* crt = n->children;
+    for(; i < K; i++)
+        (children[i]).s = (state*)(states + (i * instance->stateSize));
 
-    while(1) {
-        while(crt->children != NULL)
-            crt = crt->children;
+}
 
-        freeState(crt->s);
 
-        while((crt != n) && (crt->id >= (K - 1))) {
-            crt = crt->father;
+/* Returns NULL if the memory limit does not leave room for the children. */
+static uct_node* allocChildren(uct_instance* instance, region* r) {
 
-            if(crt) {
-                free(crt->children);
-                freeState(crt->s);
-            }
-        }
+    uct_node* children = (uct_node*)region_alloc(r, instance->childrenSize);
 
-        if(crt != n)
-            crt = crt->father->children + crt->id + 1;
-        else
-            return;
+    if(children != NULL) {
+        setStates(instance, children);
+        STATS_ADD(&instance->stats, nbAllocations, 1);
     }
 
+    return children;
+
+}
+
+
+/* Releases r and counts it as one free. */
+static void releaseRegion(uct_instance* instance, region* r) {
+
+    STATS_ADD(&instance->stats, nbFrees, region_getSize(r) > 0 ? 1 : 0);
+    region_release(r);
+
+}
+
+
+static void deleteTree(uct_instance* instance) {
+
+    unsigned int i = 0;
+
+    for(; i <= K; i++)
+        releaseRegion(instance, instance->regions + i);
+    releaseRegion(instance, &instance->oldRegion);
+
+    freeState(instance->root->s);
+
 }
 
 
 void uct_resetInstance(uct_instance* instance, state* initial) {
 
+    unsigned int i = 0;
+
+    for(; i < instance->nbWorkers; i++)
+        uct_resetInstance(instance->workers[i], initial);
+
     if(instance->root != NULL) {
-        deleteTree(instance->root);
+        deleteTree(instance);
         free(instance->root);
     }
 
@@ -118,6 +178,7 @@ void uct_resetInstance(uct_instance* instance, state* initial) {
     instance->root->trajectoryId = 0;
     instance->root->id = K;
     instance->root->isClosedBranch = 0;
+    instance->root->isLocked = 0;
     instance->root->father = NULL;
     instance->root->children = NULL;
 
@@ -129,12 +190,63 @@ void uct_resetInstance(uct_instance* instance, state* initial) {
 }
 
 
+/* Releases the region of the root child subtree with the lowest discounted sum, the closed ones first, which does not
+ * contain the next leaf to open or the optimal leaf. Its root child is then a closed leaf. Returns 0 if no region has
+ * memory to give back, 1 else. */
+static char pruneSubtree(uct_instance* instance) {
+
+    uct_node* children = instance->root->children;
+    uct_node* pruned = NULL;
+    double minValue = HUGE_VAL;
+    unsigned int i = 0;
+
+    if(children == NULL)
+        return 0;
+
+    for(; i < K; i++) {
+        double value = (children[i]).isClosedBranch ? -HUGE_VAL : (children[i]).crtOptimalLeaf->discountedSum;
+
+        if((i != instance->root->trajectoryId) && (i != instance->crtOptimalAction) && (region_getSize(instance->regions + i) > 0) && ((pruned == NULL) || (value < minValue))) {
+            pruned = children + i;
+            minValue = value;
+        }
+    }
+
+    if(pruned == NULL)
+        return 0;
+
+    releaseRegion(instance, instance->regions + pruned->id);                                         // What was kept from previous roots is only released with them
+
+    instance->root->n -= pruned->n - 1;
+    pruned->n = 1;
+    pruned->children = NULL;
+    pruned->isClosedBranch = 1;
+    pruned->crtOptimalLeaf = pruned;
+    pruned->crtNextOpennedLeaf = pruned;
+    instance->nbPrunedSubtrees++;
+
+    crtKernel->updateNode(instance, instance->root);
+    instance->nextOpennedNode = instance->root->crtNextOpennedLeaf;
+
+    return 1;
+
+}
+
+
 static void buildingTrajectory(uct_instance* instance) {
 
     uct_node* n = instance->nextOpennedNode;
+    double gammaPower = discount_getPowers(instance->discount, n->depth + 1)[n->depth];
     unsigned int i = 0;
 
-    n->children = (uct_node*)malloc(K * sizeof(uct_node));
+    n->children = allocChildren(instance, instance->regions + (n == instance->root ? K : instance->root->trajectoryId));     // Allocated in the region of the root child it descends from
+
+    if(n->children == NULL) {
+        if(!instance->isPruningUsed || !pruneSubtree(instance))                             // The next leaf is the one to open once a subtree is released
+            instance->isMemoryFull = 1;
+        return;
+    }
+
     n->isClosedBranch = 1;
 
     n->n+=K;
@@ -143,19 +255,22 @@ static void buildingTrajectory(uct_instance* instance) {
 
     n->trajectoryId = 0;
 
+    STATS_TIME(&instance->stats, simulationTime, nextStatesRewardsInto(n->s, (n->children[0]).s, instance->rewards, instance->results)); // The K children are simulated at once
+    instance->crtNbEvaluations += K;
+    instance->totalNbEvaluations += K;
+    instance->realNbEvaluations += K;
+
     for(;i < K; i++) {
         (n->children[i]).id = i;
 
-        (n->children[i]).isClosedBranch = nextStateReward(n->s, actions[i], &((n->children[i]).s), &((n->children[i]).reward)) < 0 ? 1 : 0;
-        instance->crtNbEvaluations++;
-        instance->totalNbEvaluations++;
-        instance->realNbEvaluations++;
+        (n->children[i]).reward = instance->rewards[i];
+        (n->children[i]).isClosedBranch = instance->results[i] < 0 ? 1 : 0;
 
-        (n->children[i]).discountedSum = n->discountedSum + (instance->gammaPowers[n->depth] *  (n->children[i]).reward);
+        (n->children[i]).discountedSum = n->discountedSum + (gammaPower *  (n->children[i]).reward);
         (n->children[i]).crtOptimalLeaf = n->children + i;
         (n->children[i]).crtNextOpennedLeaf = n->children + i;
 
-        if(n->depth == ((UCT_MAX_DEPTH) - 1))
+        if((n->depth - instance->root->depth) >= (instance->maxDepth - 1))
             (n->children[i]).isClosedBranch = 1;
 
         if(!(n->children[i]).isClosedBranch) {
@@ -179,76 +294,329 @@ static void buildingTrajectory(uct_instance* instance) {
 
         (n->children[i]).depth = n->depth + 1;
         (n->children[i]).n = 1;
+        (n->children[i]).isLocked = 0;
 
         (n->children[i]).children = NULL;
         (n->children[i]).father = n;
     }
 
-    n = n->father;
-
-    while(n != NULL) {
-        double crtMaxBound = 0.0;
-
-        n->isClosedBranch = 1;
-        n->n += K;
-
-        for(i = 0; i < K; i++) {
-            if(!(n->children[i]).isClosedBranch) {
-                double crtBound = (n->children[i]).crtOptimalLeaf->discountedSum + (instance->bounds[n->depth] * sqrt(log(n->n) / (double)(n->children[i]).n));
-                if(n->isClosedBranch) {
-                    n->isClosedBranch = 0;
-                    n->crtNextOpennedLeaf = (n->children[i]).crtNextOpennedLeaf;
-                    n->crtOptimalLeaf = (n->children[i]).crtOptimalLeaf;
-                    crtMaxBound = crtBound;
-                    n->trajectoryId = i;
-                } else {
-                    if(crtBound > crtMaxBound) {
-                        n->crtNextOpennedLeaf = (n->children[i]).crtNextOpennedLeaf;
-                        crtMaxBound = crtBound;
-                        n->trajectoryId = i;
-                    }
-                    if((n->children[i]).crtOptimalLeaf->discountedSum > n->crtOptimalLeaf->discountedSum)
-                        n->crtOptimalLeaf = (n->children[i]).crtOptimalLeaf;
-                }
-            }
+    STATS_TIME(&instance->stats, bookkeepingTime, crtKernel->updateAncestors(instance, n));
+
+    instance->nextOpennedNode = instance->root->crtNextOpennedLeaf;
+
+}
+
+
+static void growTree(uct_instance* instance, unsigned int maxNbEvaluations) {
+
+    instance->realNbEvaluations = 0;
+    instance->isMemoryFull = 0;
+    instance->nbPrunedSubtrees = 0;
+
+    while((instance->crtNbEvaluations < maxNbEvaluations) && !instance->root->isClosedBranch && !instance->isMemoryFull && !deadline_isOver(&instance->clock))
+        buildingTrajectory(instance);
+
+    STATS_SET(&instance->stats, nbNodes, instance->root->n);
+    STATS_SET(&instance->stats, maxDepth, uct_getMaxDepth(instance));
+
+}
+
+
+/* Grows the tree of one thread with its share of the budget, up to the deadline of the instance. The first tree is the
+ * one of the instance itself. */
+static void growWorkerTree(void* data, unsigned int taskId) {
+
+    uct_instance* instance = (uct_instance*)data;
+    uct_instance* worker = taskId == 0 ? instance : instance->workers[taskId - 1];
+    unsigned int maxNbEvaluations = (instance->maxNbEvaluations / instance->nbThreads) + (taskId < (instance->maxNbEvaluations % instance->nbThreads) ? 1 : 0);
+
+    if(worker != instance)
+        deadline_start(&worker->clock, instance->clock.deadline);
+
+    growTree(worker, maxNbEvaluations);
+
+    if(worker != instance)
+        deadline_start(&worker->clock, 0);
+
+}
+
+
+static void lockNode(uct_node* n) {
+
+    while(__atomic_test_and_set(&n->isLocked, __ATOMIC_ACQUIRE));
+
+}
+
+
+static void unlockNode(uct_node* n) {
+
+    __atomic_clear(&n->isLocked, __ATOMIC_RELEASE);
+
+}
+
+
+/* Goes down a shared tree along the best bounds and returns the leaf reached, locked, or NULL if it is being openned by
+ * another thread. K is added to the visits of each node on the way as the expansion will do it: until then, it is a
+ * virtual loss which sends the other threads elsewhere. It is taken back if no leaf is returned. */
+static uct_node* selectLeaf(uct_instance* instance, unsigned int* rootChildId) {
+
+    uct_node* n = instance->root;
+
+    __atomic_add_fetch(&n->n, K, __ATOMIC_RELAXED);
+
+    while(1) {
+        uct_node* children = __atomic_load_n(&n->children, __ATOMIC_ACQUIRE);
+        unsigned int bestChild = 0;
+
+        if(children == NULL) {
+            if(__atomic_test_and_set(&n->isLocked, __ATOMIC_ACQUIRE))
+                break;
+
+            if(__atomic_load_n(&n->children, __ATOMIC_ACQUIRE) == NULL)
+                return n;
+
+            unlockNode(n);                                                                  // Openned between the two, let's go on down
+            continue;
         }
 
-        n = n->father;
+        bestChild = crtKernel->getBestChild(instance, n, children);
+        if(bestChild == K)
+            break;
+
+        if(n == instance->root)
+            *rootChildId = bestChild;
+
+        n = children + bestChild;
+        __atomic_add_fetch(&n->n, K, __ATOMIC_RELAXED);
     }
 
-    instance->nextOpennedNode = instance->root->crtNextOpennedLeaf;
+    for(; n != NULL; n = n->father)
+        __atomic_sub_fetch(&n->n, K, __ATOMIC_RELAXED);
+
+    return NULL;
+
+}
+
+
+/* Refreshes the ancestors of n one after the other. */
+static void refreshAncestors(uct_instance* instance, uct_node* n) {
+
+    for(n = n->father; n != NULL; n = n->father) {
+        lockNode(n);
+        crtKernel->refreshNode(instance, n);
+        unlockNode(n);
+    }
+
+}
+
+
+/* Opens the locked leaf n of a shared tree: only the allocation is done under the mutex of the instance. The children
+ * are visible to the other threads once they are set, then the ancestors are refreshed one after the other. Returns 0
+ * if the memory limit does not leave room for the children: n is left as it was, and the virtual loss taken back. */
+static char openSharedLeaf(uct_instance* instance, uct_node* n, unsigned int rootChildId, double* rewards, char* results) {
+
+    uct_node* children = NULL;
+    uct_node* crtOptimalLeaf = NULL;
+    double gammaPower = discount_getPowers(instance->discount, n->depth + 1)[n->depth];
+    unsigned int trajectoryId = 0;
+    unsigned int i = 0;
+
+    pthread_mutex_lock(&instance->mutex);
+    children = allocChildren(instance, instance->regions + (n == instance->root ? K : rootChildId));
+    pthread_mutex_unlock(&instance->mutex);
+
+    if(children == NULL) {                                                                  // The subtrees of a shared tree are not released: the threads stop
+        unlockNode(n);
+
+        for(; n != NULL; n = n->father)
+            __atomic_sub_fetch(&n->n, K, __ATOMIC_RELAXED);
+
+        __atomic_store_n(&instance->isMemoryFull, 1, __ATOMIC_RELAXED);
+
+        return 0;
+    }
+
+    STATS_TIME(&instance->stats, simulationTime, nextStatesRewardsInto(n->s, children[0].s, rewards, results));
+
+    for(; i < K; i++) {
+        (children[i]).id = i;
+        (children[i]).reward = rewards[i];
+        (children[i]).isClosedBranch = ((results[i] < 0) || ((n->depth - instance->root->depth) >= (instance->maxDepth - 1))) ? 1 : 0;
+        (children[i]).discountedSum = n->discountedSum + (gammaPower * (children[i]).reward);
+        (children[i]).crtOptimalLeaf = children + i;
+        (children[i]).crtNextOpennedLeaf = children + i;
+        (children[i]).trajectoryId = 0;
+        (children[i]).depth = n->depth + 1;
+        (children[i]).n = 1;
+        (children[i]).isLocked = 0;
+        (children[i]).children = NULL;
+        (children[i]).father = n;
+
+        if(!(children[i]).isClosedBranch && ((crtOptimalLeaf == NULL) || ((children[i]).discountedSum > crtOptimalLeaf->discountedSum))) {
+            crtOptimalLeaf = children + i;
+            trajectoryId = i;
+        }
+    }
+
+    if(crtOptimalLeaf != NULL) {
+        __atomic_store_n(&n->crtOptimalLeaf, crtOptimalLeaf, __ATOMIC_RELEASE);
+        __atomic_store_n(&n->crtNextOpennedLeaf, crtOptimalLeaf, __ATOMIC_RELEASE);
+        __atomic_store_n(&n->trajectoryId, trajectoryId, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&n->isClosedBranch, crtOptimalLeaf == NULL, __ATOMIC_RELEASE);
+    __atomic_store_n(&n->children, children, __ATOMIC_RELEASE);
+    unlockNode(n);
+
+    pthread_mutex_lock(&instance->mutex);
+    if(n == instance->crtOptimalLeaf)
+        instance->crtOptimalValue = -1.0;
+
+    for(i = 0; i < K; i++) {
+        if((children[i]).discountedSum >= instance->crtOptimalValue) {
+            instance->crtOptimalLeaf = children + i;
+            instance->crtOptimalValue = (children[i]).discountedSum;
+            instance->crtOptimalAction = n == instance->root ? i : rootChildId;
+        }
+    }
+    pthread_mutex_unlock(&instance->mutex);
+
+    __atomic_add_fetch(&instance->totalNbEvaluations, K, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&instance->realNbEvaluations, K, __ATOMIC_RELAXED);
+
+    STATS_TIME(&instance->stats, bookkeepingTime, refreshAncestors(instance, n));
+
+    return 1;
+
+}
+
+
+/* Opens leaves of the shared tree until the budget is spent or the deadline is over. The K evaluations of an expansion
+ * are counted before looking for its leaf so that the threads together do not go over the budget. Each thread checks
+ * the deadline on its own copy of the clock. */
+static void growSharedTree(void* data, unsigned int taskId) {
+
+    uct_instance* instance = (uct_instance*)data;
+    double* rewards = (double*)malloc(sizeof(double) * K);
+    char* results = (char*)malloc(sizeof(char) * K);
+    deadline_clock clock = instance->clock;
+
+    (void)taskId;
+
+    while(!__atomic_load_n(&instance->root->isClosedBranch, __ATOMIC_ACQUIRE) && !__atomic_load_n(&instance->isMemoryFull, __ATOMIC_RELAXED) && !deadline_isOver(&clock)) {
+        uct_node* leaf = NULL;
+        unsigned int rootChildId = 0;
+
+        if(__atomic_fetch_add(&instance->crtNbEvaluations, K, __ATOMIC_RELAXED) >= instance->maxNbEvaluations) {
+            __atomic_sub_fetch(&instance->crtNbEvaluations, K, __ATOMIC_RELAXED);
+            break;
+        }
+
+        while((leaf == NULL) && !__atomic_load_n(&instance->root->isClosedBranch, __ATOMIC_ACQUIRE))
+            leaf = selectLeaf(instance, &rootChildId);
+
+        if(leaf == NULL) {
+            __atomic_sub_fetch(&instance->crtNbEvaluations, K, __ATOMIC_RELAXED);
+            break;
+        }
+
+        if(!openSharedLeaf(instance, leaf, rootChildId, rewards, results)) {
+            __atomic_sub_fetch(&instance->crtNbEvaluations, K, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+
+    free(rewards);
+    free(results);
 
 }
 
 
+/* With several threads and a shared tree, the threads open its leaves together. Else each one grows its own tree from
+ * the root: the action leading to the best discounted sum over all the trees is taken, the first tree winning the ties,
+ * and every tree will keep this action when keeping the subtree. */
 action* uct_planning(uct_instance* instance, unsigned int maxNbEvaluations) {
 
-    instance->realNbEvaluations = 0;
+    unsigned int i = 0;
 
-    while((instance->crtNbEvaluations < maxNbEvaluations) && !instance->root->isClosedBranch)
-        buildingTrajectory(instance);
+    if(instance->threads == NULL) {
+        growTree(instance, maxNbEvaluations);
+
+        return actions[instance->crtOptimalAction];
+    }
+
+    instance->maxNbEvaluations = maxNbEvaluations;
+
+    if(instance->isTreeShared) {
+        instance->realNbEvaluations = 0;
+        instance->isMemoryFull = 0;
+        instance->nbPrunedSubtrees = 0;
+        thread_pool_run(instance->threads, growSharedTree, instance, instance->nbThreads);
+        instance->nextOpennedNode = instance->root->crtNextOpennedLeaf;
+
+        STATS_SET(&instance->stats, nbNodes, instance->root->n);
+        STATS_SET(&instance->stats, maxDepth, uct_getMaxDepth(instance));
+
+        return actions[instance->crtOptimalAction];
+    }
+
+    thread_pool_run(instance->threads, growWorkerTree, instance, instance->nbThreads);
+
+    for(; i < instance->nbWorkers; i++) {
+        uct_instance* worker = instance->workers[i];
+
+        if(worker->crtOptimalValue > instance->crtOptimalValue) {
+            instance->crtOptimalValue = worker->crtOptimalValue;
+            instance->crtOptimalAction = worker->crtOptimalAction;
+        }
+
+        instance->realNbEvaluations += worker->realNbEvaluations;
+        instance->isMemoryFull |= worker->isMemoryFull;
+        instance->nbPrunedSubtrees += worker->nbPrunedSubtrees;
+        STATS_MERGE(&instance->stats, &worker->stats);
+    }
+
+    for(i = 0; i < instance->nbWorkers; i++)
+        instance->workers[i]->crtOptimalAction = instance->crtOptimalAction;
 
     return actions[instance->crtOptimalAction];
 
 }
 
 
+/* Same as uct_planning, but also stops at deadline, in nanoseconds on the clock of deadline_now, and then returns the
+ * best action found so far. The number of evaluations done is in realNbEvaluations. */
+action* uct_planningDeadline(uct_instance* instance, unsigned int maxNbEvaluations, uint64_t deadline) {
+
+    action* a = NULL;
+
+    deadline_start(&instance->clock, deadline);
+    a = uct_planning(instance, maxNbEvaluations);
+    deadline_start(&instance->clock, 0);
+
+    return a;
+
+}
+
+
+/* Rebases the discounted sums and the depths on the root. */
 static void updateValues(uct_instance* instance) {
 
     unsigned int crtDepth = 1;
 
     uct_node* crt = instance->root->children;
 
+    instance->root->discountedSum = 0.0;
+    instance->root->depth = 0;
+
     while(1) {
         while(crt->children != NULL) {
-            crt->discountedSum = crt->father->discountedSum + (instance->gammaPowers[crtDepth - 1] * crt->reward);
+            crt->discountedSum = crt->father->discountedSum + (discount_getPowers(instance->discount, crtDepth)[crtDepth - 1] * crt->reward);
+            crt->depth = crtDepth;
             crtDepth++;
-            instance->crtNbEvaluations++;
             crt = crt->children;
         }
 
-        instance->crtNbEvaluations++;
-        crt->discountedSum = crt->father->discountedSum + (instance->gammaPowers[crtDepth - 1] * crt->reward);
+        crt->discountedSum = crt->father->discountedSum + (discount_getPowers(instance->discount, crtDepth)[crtDepth - 1] * crt->reward);
         crt->depth = crtDepth;
 
         while(crt && (crt->id >= (K - 1))) {
@@ -277,32 +645,111 @@ static void updateCrtOptimalAction(uct_instance* instance) {
 }
 
 
-void uct_keepSubtree(uct_instance* instance) {
+static uct_node* moveChildren(uct_instance* instance, uct_node* n, unsigned int regionId) {
+
+    uct_node* children = (uct_node*)region_alloc(instance->regions + regionId, instance->childrenSize);
+    unsigned int i = 0;
+
+    STATS_ADD(&instance->stats, nbAllocations, 1);
+
+    memcpy(children, n->children, instance->childrenSize);
+    setStates(instance, children);
+
+    for(; i < K; i++) {
+        (n->children[i]).father = children + i;                                             // The old node now forwards to its copy
+        (children[i]).father = n;
+    }
+
+    n->children = children;
+
+    return children;
+
+}
+
+
+/* Copies the tree below the root into the current regions, then releases what was kept from previous roots. */
+static void evacuateTree(uct_instance* instance) {
+
+    uct_node* crt = instance->root;
+    unsigned int regionId = K;
+
+    while(1) {                                                                              // First pass: copy every children array
+        while(crt->children != NULL) {
+            if(crt->father == instance->root)
+                regionId = crt->id;
+
+            crt = moveChildren(instance, crt, crt == instance->root ? K : regionId);
+        }
+
+        while((crt != instance->root) && (crt->id >= (K - 1)))
+            crt = crt->father;
+
+        if(crt == instance->root)
+            break;
+
+        crt++;
+    }
+
+    while(1) {                                                                              // Second pass: follow the forwards left in the old nodes
+        while(1) {
+            crt->crtOptimalLeaf = crt->crtOptimalLeaf->father;
+            crt->crtNextOpennedLeaf = crt->crtNextOpennedLeaf->father;
+
+            if(crt->children == NULL)
+                break;
+
+            crt = crt->children;
+        }
+
+        while((crt != instance->root) && (crt->id >= (K - 1)))
+            crt = crt->father;
+
+        if(crt == instance->root)
+            break;
+
+        crt++;
+    }
+
+    releaseRegion(instance, &instance->oldRegion);
+
+}
+
+
+static void keepSubtree(uct_instance* instance) {
+
+    unsigned int i = 0;
 
     if(instance->root->children) {
-        unsigned int i = 0;
         unsigned int keptSubtreeId = instance->crtOptimalAction;
         uct_node* cuttedSubtrees = instance->root->children;
 
-        freeState(instance->root->s);
-        instance->root->s = (cuttedSubtrees[keptSubtreeId]).s;
+        memcpy(instance->root->s, (cuttedSubtrees[keptSubtreeId]).s, instance->stateSize);   // The state of the root is the only one not in a region
         instance->root->reward = 0.0;
-        instance->root->discountedSum = 0.0;
-        instance->root->depth = 0;
+        instance->root->discountedSum = (cuttedSubtrees[keptSubtreeId]).discountedSum;    // The values below stay the ones from the previous roots
+        instance->root->depth = (cuttedSubtrees[keptSubtreeId]).depth;
         instance->root->n = (cuttedSubtrees[keptSubtreeId]).n;
         instance->root->trajectoryId = (cuttedSubtrees[keptSubtreeId]).trajectoryId;
         instance->root->id = K;
         instance->root->isClosedBranch = (cuttedSubtrees[keptSubtreeId]).isClosedBranch;
         instance->root->children = (cuttedSubtrees[keptSubtreeId]).children;
+        instance->root->crtOptimalLeaf = (cuttedSubtrees[keptSubtreeId]).crtOptimalLeaf;
+        instance->root->crtNextOpennedLeaf = (cuttedSubtrees[keptSubtreeId]).crtNextOpennedLeaf;
 
-        for(; i < keptSubtreeId; i++)
-            deleteTree(cuttedSubtrees + i);
-        for(i = keptSubtreeId + 1; i < K; i++)
-            deleteTree(cuttedSubtrees + i);
-               
-        instance->crtNbEvaluations = 0;
+        region_append(&instance->oldRegion, instance->regions + keptSubtreeId);            // The kept subtree joins what was kept from previous roots...
+
+        for(i = 0; i < K; i++) {                                                            // ...and the cutted ones are released at once
+            if(i != keptSubtreeId)
+                releaseRegion(instance, instance->regions + i);
+        }
+        releaseRegion(instance, instance->regions + K);
+
+        instance->crtNbEvaluations = instance->root->n - 1;
 
         if(instance->root->children == NULL) {
+            releaseRegion(instance, &instance->oldRegion);
+
+            instance->root->discountedSum = 0.0;
+            instance->root->depth = 0;
             instance->root->crtOptimalLeaf = instance->root;
             instance->root->crtNextOpennedLeaf = instance->root;
             instance->nextOpennedNode = instance->root;
@@ -312,26 +759,146 @@ void uct_keepSubtree(uct_instance* instance) {
         } else {
             for(i = 0; i < K; i++)
                 (instance->root->children[i]).father = instance->root;
-            instance->root->crtOptimalLeaf = (cuttedSubtrees[keptSubtreeId]).crtOptimalLeaf;
-            instance->root->crtNextOpennedLeaf = (cuttedSubtrees[keptSubtreeId]).crtNextOpennedLeaf;
 
-            updateValues(instance);
+            if((instance->root->depth >= instance->maxDepth) || (discount_getPowers(instance->discount, instance->root->depth + 1)[instance->root->depth] < MIN_ROOT_GAMMA_POWER))
+                STATS_TIME(&instance->stats, updateValuesTime, updateValues(instance));
+
+            if(!instance->root->isClosedBranch && (region_getSize(&instance->oldRegion) > (2 * instance->crtNbEvaluations * sizeof(uct_node))) && region_hasRoomFor(instance->pool, instance->crtNbEvaluations / K, instance->childrenSize, K + 1))
+                evacuateTree(instance);                                                     // Once more than half of the old region is dead, copying the rest costs less than what it frees
+
             instance->nextOpennedNode = instance->root->crtNextOpennedLeaf;
             instance->crtOptimalLeaf = instance->root->crtOptimalLeaf;
             instance->crtOptimalValue = instance->crtOptimalLeaf->discountedSum;
             updateCrtOptimalAction(instance);
         }
-        free(cuttedSubtrees);
     }
 
 }
 
 
+void uct_keepSubtree(uct_instance* instance) {
+
+    unsigned int i = 0;
+
+    for(; i < instance->nbWorkers; i++)
+        uct_keepSubtree(instance->workers[i]);
+
+    STATS_TIME(&instance->stats, keepSubtreeTime, keepSubtree(instance));
+
+}
+
+
+/* The cutted subtrees are released by the reclaimer if it is not NULL, for the other trees as well. */
+void uct_setReclaimer(uct_instance* instance, region_reclaimer* reclaimer) {
+
+    unsigned int i = 0;
+
+    for(; i < instance->nbWorkers; i++)
+        uct_setReclaimer(instance->workers[i], reclaimer);
+
+    region_setReclaimer(instance->pool, reclaimer);
+
+}
+
+
+/* Plans on nbThreads threads if there are more than one. With isTreeShared, they all grow the tree of the instance.
+ * Else each one grows its own tree, and the trees differ by their exploration: the bounds of the i-th other one are
+ * scaled by sqrt(2) to the power 1, -1, 2, -2... */
+void uct_setThreads(uct_instance* instance, unsigned int nbThreads, char isTreeShared) {
+
+    unsigned int i = 0;
+
+    if(instance->threads != NULL) {
+        for(; i < instance->nbWorkers; i++)
+            uct_uninitInstance(instance->workers + i);
+
+        free(instance->workers);
+        thread_pool_uninit(&instance->threads);
+        if(instance->isTreeShared)
+            pthread_mutex_destroy(&instance->mutex);
+
+        instance->workers = NULL;
+        instance->nbWorkers = 0;
+    }
+
+    instance->nbThreads = nbThreads > 0 ? nbThreads : 1;
+    instance->isTreeShared = isTreeShared;
+
+    if(instance->nbThreads > 1) {
+        instance->threads = thread_pool_init(instance->nbThreads);
+
+        if(isTreeShared) {
+            pthread_mutex_init(&instance->mutex, NULL);
+            uct_setMemoryLimit(instance, instance->maxNbBytes, instance->isPruningUsed);
+            return;
+        }
+
+        instance->nbWorkers = instance->nbThreads - 1;
+        instance->workers = (uct_instance**)malloc(sizeof(uct_instance*) * instance->nbWorkers);
+
+        for(i = 0; i < instance->nbWorkers; i++) {
+            uct_instance* worker = uct_initInstance(instance->root != NULL ? instance->root->s : NULL, instance->gamma);
+
+            worker->explorationFactor = pow(sqrt(2.0), (i % 2) ? -(double)((i / 2) + 1) : (double)((i / 2) + 1));
+            worker->maxDepth = instance->maxDepth;
+
+            region_setReclaimer(worker->pool, instance->pool->reclaimer);
+
+            instance->workers[i] = worker;
+        }
+    }
+
+    uct_setMemoryLimit(instance, instance->maxNbBytes, instance->isPruningUsed);
+
+}
+
+
+/* Bounds the memory taken by the nodes below the root, their states included, to maxNbBytes (0 for no bound), which is
+ * split evenly between the trees when each thread grows its own. A planning reaching it stops, or with isPruningUsed,
+ * releases the least promising subtrees of the root as long as one of them has memory to give back. The threads of a
+ * shared tree always stop. */
+void uct_setMemoryLimit(uct_instance* instance, size_t maxNbBytes, char isPruningUsed) {
+
+    unsigned int i = 0;
+
+    instance->maxNbBytes = maxNbBytes;
+    instance->isPruningUsed = isPruningUsed;
+    region_setPoolLimit(instance->pool, maxNbBytes / (instance->nbWorkers + 1));
+
+    for(; i < instance->nbWorkers; i++) {
+        region_setPoolLimit(instance->workers[i]->pool, maxNbBytes / (instance->nbWorkers + 1));
+        instance->workers[i]->isPruningUsed = isPruningUsed;
+    }
+
+}
+
+
+/* The leaves maxDepth - 1 deeper than the root are not openned, UCT_MAX_DEPTH - 1 by default. */
+void uct_setMaxDepth(uct_instance* instance, unsigned int maxDepth) {
+
+    unsigned int i = 0;
+
+    instance->maxDepth = maxDepth > 1 ? maxDepth : 2;
+
+    for(; i < instance->nbWorkers; i++)
+        instance->workers[i]->maxDepth = instance->maxDepth;
+
+}
+
+
 void uct_uninitInstance(uct_instance** instance) {
 
-    deleteTree((*instance)->root);
+    uct_setThreads(*instance, 1, 0);
+
+    deleteTree(*instance);
     free((*instance)->root);
 
+    free((*instance)->rewards);
+    free((*instance)->results);
+    free((*instance)->regions);
+    region_uninitPool(&(*instance)->pool);
+    discount_releaseTable(&(*instance)->discount);
+
     free((*instance));
     *instance = NULL;
 
@@ -36,30 +36,35 @@
 #define UCT_H
 
 
-#ifdef LIMITED_DEPTH
-#define UCT_MAX_DEPTH 512
-#else
-#define UCT_MAX_DEPTH 32768
-#endif
+#define UCT_MAX_DEPTH 32768             // Default depth limit of the tree below the root
 
 #include "../../problems/generative_model.h"
+#include "../region/region.h"
+#include "../thread_pool/thread_pool.h"
+#include "../discount/discount.h"
+#include "../deadline/deadline.h"
+#include "../stats/stats.h"
 
+/* Keeping a subtree does not update the nodes below the new root: their discounted sums and depths stay the ones from
+ * the root the instance was reset on, which only scales and shifts every value the same way. They are rebased on the
+ * root once the power of gamma at its depth gets too small. */
 typedef struct uct_node_struct {
         state* s;                                   // The state associated with this node
         double reward;                              // The reward associated with the transition to this state
         double discountedSum;                       // The discounted sum of reward from the root to this state
         unsigned int depth;                         // The depth of this node within the tree
-        unsigned int n;
+        unsigned int n;                             // 1 plus the number of nodes below this one
         struct uct_node_struct* crtOptimalLeaf;     // The leaf with the biggest discounted sum of reward within this subtree
         struct uct_node_struct* crtNextOpennedLeaf; // The next leaf that should be openned within this subtree
         unsigned int trajectoryId;
 		unsigned int id;                            // Index of the node in the children array of his father. Not useful for root node
 		char isClosedBranch;                        // 1 if leaves from this node or the current leaf don't need to be openned later, 0 else
+		char isLocked;                              // 1 while a thread of a shared tree opens this leaf or refreshes this node, 0 else
 		struct uct_node_struct* father;             // Father of the node. NULL if node is the root
 		struct uct_node_struct* children;           // Array of K children. NULL if node is a leaf
 }	uct_node;
 
-typedef struct {
+typedef struct uct_instance_struct {
 
         double gamma;
         uct_node* root;
@@ -72,17 +77,48 @@ typedef struct {
         double crtOptimalValue;
         uct_node* crtOptimalLeaf;
 
-        double gammaPowers[UCT_MAX_DEPTH];
-        double bounds[UCT_MAX_DEPTH];
+        discount_table* discount;           // Shared by the instances of the same discount factor
+        double explorationFactor;           // Scales the bounds of the tree
+        unsigned int maxDepth;              // Leaves maxDepth - 1 deeper than the root are closed
 
         uct_node* nextOpennedNode;
 
+        size_t stateSize;                   // Size of a state of the generative model
+        size_t childrenSize;                // Size of an array of K children followed by their states
+        double* rewards;                    // The K rewards of the last expansion
+        char* results;                      // The K results of the last expansion
+
+        region_pool* pool;                  // Chunks shared by every region of the instance
+        region* regions;                    // K + 1 regions: the children arrays of each root child subtree, then the children array of the root
+        region oldRegion;                   // Children arrays kept from previous roots
+
+        unsigned int nbThreads;
+        thread_pool* threads;               // Threads growing the tree(s). NULL if the planning is sequential
+        char isTreeShared;                  // 1 if the threads grow the tree of the instance together, 0 if each one grows its own
+        unsigned int nbWorkers;             // Number of instances growing the other trees: nbThreads - 1, or 0 if the tree is shared
+        struct uct_instance_struct** workers;
+        unsigned int maxNbEvaluations;      // The budget of the current planning
+        pthread_mutex_t mutex;              // Taken by the threads of a shared tree to allocate children and to update the optimal leaf
+
+        size_t maxNbBytes;                  // Bound on the memory of the tree(s), 0 if there is none
+        char isPruningUsed;                 // 1 if the least promising subtrees are released when a tree reaches the memory limit, 0 if the planning stops
+        char isMemoryFull;                  // 1 if the last planning stopped at the memory limit, 0 else
+        unsigned int nbPrunedSubtrees;      // Number of subtrees released by the last planning to stay within the memory limit
+
+        deadline_clock clock;               // Deadline of the planning being done, if it has one
+        stats_counters stats;               // Where the time of the plannings goes, counted when built with USE_STATS
+
 }   uct_instance;
 
 uct_instance* uct_initInstance(state* initial, double discountFactor);
 void uct_resetInstance(uct_instance* instance, state* initial);
 action* uct_planning(uct_instance* instance, unsigned int maxNbEvaluations);
+action* uct_planningDeadline(uct_instance* instance, unsigned int maxNbEvaluations, uint64_t deadline);
 void uct_keepSubtree(uct_instance* instance);
+void uct_setReclaimer(uct_instance* instance, region_reclaimer* reclaimer);
+void uct_setThreads(uct_instance* instance, unsigned int nbThreads, char isTreeShared);
+void uct_setMemoryLimit(uct_instance* instance, size_t maxNbBytes, char isPruningUsed);
+void uct_setMaxDepth(uct_instance* instance, unsigned int maxDepth);
 unsigned int uct_getMaxDepth(uct_instance* instance);
 void uct_uninitInstance(uct_instance** instance);
 
@@ -0,0 +1,143 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+/* The loops of the UCT planning over the children of a node, compiled by uct.c once per branching factor through
+ * ../kernel/kernel.h. */
+
+/* Sets the values of n from the ones of its children: closed or not, and if not, the next leaf to open and the optimal
+ * leaf. */
+static void KERNEL(updateNode)(uct_instance* instance, uct_node* n) {
+
+    double bound = discount_getBounds(instance->discount, n->depth + 1)[n->depth] * instance->explorationFactor;
+    double logNbVisits = log(n->n);
+    double crtMaxBound = 0.0;
+    unsigned int i = 0;
+
+    n->isClosedBranch = 1;
+
+    for(; i < KERNEL_K; i++) {
+        if(!(n->children[i]).isClosedBranch) {
+            double crtBound = (n->children[i]).crtOptimalLeaf->discountedSum + (bound * sqrt(logNbVisits / (double)(n->children[i]).n));
+            if(n->isClosedBranch) {
+                n->isClosedBranch = 0;
+                n->crtNextOpennedLeaf = (n->children[i]).crtNextOpennedLeaf;
+                n->crtOptimalLeaf = (n->children[i]).crtOptimalLeaf;
+                crtMaxBound = crtBound;
+                n->trajectoryId = i;
+            } else {
+                if(crtBound > crtMaxBound) {
+                    n->crtNextOpennedLeaf = (n->children[i]).crtNextOpennedLeaf;
+                    crtMaxBound = crtBound;
+                    n->trajectoryId = i;
+                }
+                if((n->children[i]).crtOptimalLeaf->discountedSum > n->crtOptimalLeaf->discountedSum)
+                    n->crtOptimalLeaf = (n->children[i]).crtOptimalLeaf;
+            }
+        }
+    }
+
+}
+
+
+/* Updates the visits and the values from the father of the openned leaf n up to the root. */
+static void KERNEL(updateAncestors)(uct_instance* instance, uct_node* n) {
+
+    for(n = n->father; n != NULL; n = n->father) {
+        n->n += KERNEL_K;
+        KERNEL(updateNode)(instance, n);
+    }
+
+}
+
+
+/* Returns the index of the open child of n with the best bound, K if there is none. As in buildingTrajectory, the
+ * first of the best ones is taken. */
+static unsigned int KERNEL(getBestChild)(uct_instance* instance, uct_node* n, uct_node* children) {
+
+    double logNbVisits = log(__atomic_load_n(&n->n, __ATOMIC_RELAXED));
+    double bound = discount_getBounds(instance->discount, n->depth + 1)[n->depth] * instance->explorationFactor;
+    double crtMaxBound = 0.0;
+    unsigned int bestChild = KERNEL_K;
+    unsigned int i = 0;
+
+    for(; i < KERNEL_K; i++) {
+        if(!__atomic_load_n(&(children[i]).isClosedBranch, __ATOMIC_ACQUIRE)) {
+            uct_node* crtOptimalLeaf = __atomic_load_n(&(children[i]).crtOptimalLeaf, __ATOMIC_ACQUIRE);
+            double crtBound = crtOptimalLeaf->discountedSum + (bound * sqrt(logNbVisits / (double)__atomic_load_n(&(children[i]).n, __ATOMIC_RELAXED)));
+
+            if((bestChild == KERNEL_K) || (crtBound > crtMaxBound)) {
+                crtMaxBound = crtBound;
+                bestChild = i;
+            }
+        }
+    }
+
+    return bestChild;
+
+}
+
+
+/* Sets the values of n, which is locked, from the ones of its children, as done for the ancestors in
+ * buildingTrajectory. The children are not locked: a child which changes meanwhile is refreshed by the same thread
+ * before n is refreshed again, so the last refresh of n sees the last values of its children. */
+static void KERNEL(refreshNode)(uct_instance* instance, uct_node* n) {
+
+    uct_node* children = __atomic_load_n(&n->children, __ATOMIC_ACQUIRE);
+    unsigned int bestChild = KERNEL(getBestChild)(instance, n, children);
+    uct_node* crtOptimalLeaf = NULL;
+    unsigned int i = 0;
+
+    if(bestChild == KERNEL_K) {
+        __atomic_store_n(&n->isClosedBranch, 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    for(; i < KERNEL_K; i++) {
+        if(!__atomic_load_n(&(children[i]).isClosedBranch, __ATOMIC_ACQUIRE)) {
+            uct_node* childOptimalLeaf = __atomic_load_n(&(children[i]).crtOptimalLeaf, __ATOMIC_ACQUIRE);
+
+            if((crtOptimalLeaf == NULL) || (childOptimalLeaf->discountedSum > crtOptimalLeaf->discountedSum))
+                crtOptimalLeaf = childOptimalLeaf;
+        }
+    }
+
+    __atomic_store_n(&n->crtOptimalLeaf, crtOptimalLeaf, __ATOMIC_RELEASE);
+    __atomic_store_n(&n->crtNextOpennedLeaf, __atomic_load_n(&(children[bestChild]).crtNextOpennedLeaf, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    __atomic_store_n(&n->trajectoryId, bestChild, __ATOMIC_RELAXED);
+    __atomic_store_n(&n->isClosedBranch, 0, __ATOMIC_RELEASE);
+
+}
+
+
+static const uct_kernel KERNEL(kernel) = {KERNEL(updateNode), KERNEL(updateAncestors), KERNEL(getBestChild), KERNEL(refreshNode)};
@@ -1,25 +1,37 @@
 CC_OPTIONS := -O3
 USE_SDL := 1
 CC := gcc
-FLAGS := -W -Wall $(CC_OPTIONS) -ansi -std=c99 -pedantic -Werror$(if $(USE_SDL), -DUSE_SDL)
-LIBS := -lm$(if $(USE_SDL), -lSDL -lSDLmain /usr/lib/libSDL_gfx.so) -largtable2 -lgsl -lgslcblas
+FLAGS := -W -Wall $(CC_OPTIONS) -ansi -std=c99 -pedantic -Werror$(if $(USE_SDL), -DUSE_SDL)$(if $(USE_STATS), -DUSE_STATS)
+LIBS := -lm -lpthread$(if $(USE_SDL), -lSDL -lSDLmain /usr/lib/libSDL_gfx.so) -largtable2
 BIN_DIR := ../bin
 OBJ_DIR := ../obj
 
-all: $(addprefix $(BIN_DIR)/uniform_,$(PROBLEMS)) $(OBJ_DIR)/uniform_limited.o
+all: $(addprefix $(BIN_DIR)/uniform_,$(PROBLEMS))
 
-$(OBJ_DIR)/uniform.o: uniform/uniform.c uniform/uniform.h
+$(OBJ_DIR)/transposition.o: transposition/transposition.c transposition/transposition.h
 	$(CC) -c $(FLAGS) $< -o $@
 
-$(OBJ_DIR)/uniform_limited.o: uniform/uniform.c uniform/uniform.h
-	$(CC) -c $(FLAGS) -DLIMITED_DEPTH $< -o $@
+$(OBJ_DIR)/thread_pool.o: thread_pool/thread_pool.c thread_pool/thread_pool.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/discount.o: discount/discount.c discount/discount.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/deadline.o: deadline/deadline.c deadline/deadline.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/stats.o: stats/stats.c stats/stats.h deadline/deadline.h
+	$(CC) -c $(FLAGS) $< -o $@
+
+$(OBJ_DIR)/uniform.o: uniform/uniform.c uniform/uniform.h uniform/uniform_kernel.h kernel/kernel.h transposition/transposition.h thread_pool/thread_pool.h discount/discount.h deadline/deadline.h stats/stats.h
+	$(CC) -c $(FLAGS) $< -o $@
 
-$(OBJ_DIR)/uniform_drawing.o: uniform/uniform_drawing.c uniform/uniform_drawing.h uniform/uniform.h
+$(OBJ_DIR)/uniform_drawing.o: uniform/uniform_drawing.c uniform/uniform_drawing.h uniform/uniform.h thread_pool/thread_pool.h discount/discount.h deadline/deadline.h stats/stats.h
 	$(CC) -c $(FLAGS) $< -o $@
 
 $(OBJ_DIR)/main_uniform.o: uniform/main_uniform.c
 	$(CC) -c $(FLAGS) $< -o $@
 
 .SECONDEXPANSION:
-$(BIN_DIR)/uniform_%: $(OBJ_DIR)/uniform.o $(OBJ_DIR)/main_uniform.o $(OBJ_DIR)/$$*.o $(if $(USE_SDL),$(OBJ_DIR)/uniform_drawing.o) $$(if $(USE_SDL),$(OBJ_DIR)/viewer_$$*.o)
+$(BIN_DIR)/uniform_%: $(OBJ_DIR)/uniform.o $(OBJ_DIR)/transposition.o $(OBJ_DIR)/thread_pool.o $(OBJ_DIR)/discount.o $(OBJ_DIR)/deadline.o $(OBJ_DIR)/stats.o $(OBJ_DIR)/main_uniform.o $(OBJ_DIR)/$$*.o $(if $(USE_SDL),$(OBJ_DIR)/uniform_drawing.o) $$(if $(USE_SDL),$(OBJ_DIR)/viewer_$$*.o)
 	$(CC) $(FLAGS) $(LIBS) $^ -o $@
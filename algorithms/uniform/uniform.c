@@ -40,20 +40,70 @@
 #include "uniform.h"
 #include "../../problems/generative_model.h"
 
+#define MIN_ROOT_GAMMA_POWER 1e-3       // Below, the discounted sums are rebased on the root before they lose too much precision
+#define INITIAL_CAPACITY 1024           // Number of nodes the arrays first have room for
+#define ROUND_SIZE 256                  // Maximum number of leaves a thread opens in a parallel round
+
+/* The functions looping over the children of a node, compiled for the branching factors of ../kernel/kernel.h. */
+typedef struct {
+        char (*simulateChildren)(uniform_instance* instance, size_t n, char* results);
+        void (*updateValues)(uniform_instance* instance);
+}   uniform_kernel;
+
+#define KERNEL_FILE "../uniform/uniform_kernel.h"
+#include "../kernel/kernel.h"
+
+static const uniform_kernel* crtKernel = &kernelGeneric;                                    // The functions compiled for K, chosen at the initialization of an instance
+
+
 uniform_instance* uniform_initInstance(state* initial, double discountFactor) {
 
     uniform_instance* instance = (uniform_instance*)malloc(sizeof(uniform_instance));
-    unsigned int i = 1;
-
-    instance->gammaPowers[0] = 1.0;
 
-    for(; i < UNIFORM_MAX_DEPTH; i++)
-        instance->gammaPowers[i] = instance->gammaPowers[i - 1] * discountFactor;
+    crtKernel = KERNEL_SELECT(kernel);
 
     instance->gamma = discountFactor;
-    instance->root = NULL;
+    instance->discount = discount_getTable(discountFactor);
+    instance->maxDepth = UNIFORM_MAX_DEPTH;
     instance->totalNbEvaluations = 0;
 
+    instance->stateSize = getStateSize();
+    instance->capacity = INITIAL_CAPACITY;
+    instance->maxNbNodes = 0;
+    instance->discountedSums = (double*)malloc(sizeof(double) * instance->capacity);
+    instance->rewards = (double*)malloc(sizeof(double) * instance->capacity);
+    instance->states = (char*)malloc(instance->stateSize * instance->capacity);
+    instance->results = (char*)malloc(sizeof(char) * K);
+
+    instance->crtNbEvaluations = 0;
+    instance->crtDepth = 0;
+    instance->crtLevelStart = 0;
+    instance->crtLevelSize = 1;
+    instance->nextOpennedNode = 0;
+    instance->crtOptimalLeaf = 0;
+    instance->trajectoryId = 0;
+
+    instance->isMemoryFull = 0;
+    instance->table = NULL;
+
+    instance->threads = NULL;
+    instance->nbThreads = 1;
+    instance->roundResults = NULL;
+    instance->isSimulated = NULL;
+    instance->optimalLeaves = NULL;
+
+    instance->isDepthFirst = 0;
+    instance->QValues = (double*)malloc(sizeof(double) * K);
+    instance->nbOpennedLeaves = 0;
+    instance->stackSize = 0;
+    instance->stackStates = NULL;
+    instance->stackRewards = NULL;
+    instance->stackSums = NULL;
+    instance->stackIds = NULL;
+
+    deadline_init(&instance->clock);
+    stats_init(&instance->stats);
+
     if(initial != NULL)
         uniform_resetInstance(instance, initial);
 
@@ -61,143 +111,433 @@ uniform_instance* uniform_initInstance(state* initial, double discountFactor) {
 
 }
 
-static void deleteTree(uniform_node *n) {
 
-    if(n->children == NULL) {
-        freeState(n->s);
+/* Sets the next leaf to open and the level it is on from the number of nodes: as the nodes are openned in the order they
+ * are stored, the children of the next one are the first nodes not there yet. */
+static void setNextOpennedNode(uniform_instance* instance) {
 
-        return;
+    instance->nextOpennedNode = instance->crtNbEvaluations / K;
+    instance->crtDepth = 0;
+    instance->crtLevelStart = 0;
+    instance->crtLevelSize = 1;
+
+    while(instance->nextOpennedNode >= (instance->crtLevelStart + instance->crtLevelSize)) {
+        instance->crtLevelStart += instance->crtLevelSize;
+        instance->crtLevelSize *= K;
+        instance->crtDepth++;
     }
 
-    uniform_node* crt = n->children;
+}
 
-    while(1) {
-        while(crt->children != NULL)
-            crt = crt->children;
 
-        freeState(crt->s);
+void uniform_resetInstance(uniform_instance* instance, state* initial) {
 
-        while((crt != n) && (crt->id >= (K - 1))) {
-            crt = crt->father;
+    memcpy(instance->states, initial, instance->stateSize);
+    instance->rewards[0] = 0.0;
+    instance->discountedSums[0] = 0.0;
 
-            if(crt) {
-                free(crt->children);
-                freeState(crt->s);
-            }
-        }
+    instance->crtNbEvaluations = 0;
+    instance->rootDepth = 0;
+    instance->crtOptimalLeaf = 0;
+    instance->trajectoryId = 0;
 
-        if(crt != n)
-            crt = crt->father->children + crt->id + 1;
-        else
-            return;
+    setNextOpennedNode(instance);
+
+}
+
+
+/* Returns 0 if the memory limit does not leave room for nbNodes nodes. */
+static char reserveNodes(uniform_instance* instance, size_t nbNodes) {
+
+    size_t capacity = instance->capacity;
+    double* discountedSums = NULL;
+    double* rewards = NULL;
+    char* states = NULL;
+
+    if(nbNodes <= capacity)
+        return 1;
+
+    while(capacity < nbNodes)
+        capacity *= 2;
+
+    if((instance->maxNbNodes > 0) && (capacity > instance->maxNbNodes))
+        capacity = instance->maxNbNodes;
+
+    if(capacity < nbNodes)
+        return 0;
+
+    discountedSums = (double*)realloc(instance->discountedSums, sizeof(double) * capacity);
+    if(discountedSums == NULL)
+        return 0;
+    instance->discountedSums = discountedSums;
+
+    rewards = (double*)realloc(instance->rewards, sizeof(double) * capacity);
+    if(rewards == NULL)
+        return 0;
+    instance->rewards = rewards;
+
+    states = (char*)realloc(instance->states, instance->stateSize * capacity);
+    if(states == NULL)
+        return 0;
+    instance->states = states;
+
+    instance->capacity = capacity;
+    STATS_ADD(&instance->stats, nbAllocations, 3);
+
+    return 1;
+
+}
+
+
+static void insertChildren(uniform_instance* instance, size_t n, char* results) {
+
+    size_t children = (K * n) + 1;
+
+    transposition_insert(instance->table, (state*)(instance->states + (n * instance->stateSize)), (state*)(instance->states + (children * instance->stateSize)), instance->rewards + children, results);
+
+}
+
+
+/* Moves past the nbLeaves leaves just openned, to the next level if it was the last of them. */
+static void skipLeaves(uniform_instance* instance, size_t nbLeaves) {
+
+    instance->crtNbEvaluations += K * nbLeaves;
+    instance->totalNbEvaluations += K * nbLeaves;
+    instance->realNbEvaluations += K * nbLeaves;
+
+    instance->nextOpennedNode += nbLeaves;
+
+    if(instance->nextOpennedNode == (instance->crtLevelStart + instance->crtLevelSize)) {
+        instance->crtLevelStart = instance->nextOpennedNode;
+        instance->crtLevelSize *= K;
+        instance->crtDepth++;
     }
 
 }
 
 
-void uniform_resetInstance(uniform_instance* instance, state* initial) {
+static void buildingTrajectory(uniform_instance* instance) {
+
+    size_t n = instance->nextOpennedNode;
+    char isSimulated = 0;
 
-    if(instance->root != NULL) {
-        deleteTree(instance->root);
-        free(instance->root);
+    if(!reserveNodes(instance, (K * n) + 1 + K)) {
+        instance->isMemoryFull = 1;
+        return;
     }
 
-    instance->root = (uniform_node*)malloc(sizeof(uniform_node));
+    STATS_TIME(&instance->stats, simulationTime, isSimulated = crtKernel->simulateChildren(instance, n, instance->results));
 
-    instance->root->s = copyState(initial);
+    if(isSimulated && (instance->table != NULL))
+        STATS_TIME(&instance->stats, bookkeepingTime, insertChildren(instance, n, instance->results));
 
-    instance->root->father = NULL;
-    instance->root->children = NULL;
+    skipLeaves(instance, 1);
 
-    instance->root->reward = 0.0;
-    instance->root->discountedSum = 0.0;
-    instance->root->id = K;
-    instance->root->trajectoryId = 0;
+}
 
-    instance->root->crtOptimalLeaf = instance->root;
 
-    instance->crtNbEvaluations = 0;
-    instance->nextOpennedNode = instance->root;
+static void openLeaves(void* data, unsigned int taskId) {
 
-    instance->crtDepth = 0;
+    uniform_instance* instance = (uniform_instance*)data;
+    size_t i = taskId * instance->taskSize;
+    size_t end = (i + instance->taskSize) < instance->roundSize ? i + instance->taskSize : instance->roundSize;
+
+    for(; i < end; i++)
+        STATS_TIME(&instance->stats, simulationTime, instance->isSimulated[i] = crtKernel->simulateChildren(instance, instance->roundStart + i, instance->roundResults + (i * K)));
 
 }
 
 
-static void updateNextOpennedNode(uniform_instance* instance) {
+/* Parallel round: the next leaves the sequential planning would open, on the current level only, are cut into as many
+ * tasks as there are threads. As a task always opens the same leaves, and as the children simulated are added to the
+ * transposition table in the order of the leaves after the round, the tree does not depend on which thread was the
+ * fastest. The lookups of a round only see the children added before it. */
+static void buildingLevel(uniform_instance* instance, unsigned int maxNbEvaluations) {
 
-    uniform_node* crt = instance->nextOpennedNode->father;
-    uniform_node* prev = instance->nextOpennedNode;
+    size_t nbLeaves = (instance->crtLevelStart + instance->crtLevelSize) - instance->nextOpennedNode;
+    size_t nbLeftLeaves = (maxNbEvaluations - instance->crtNbEvaluations + K - 1) / K;
+    size_t i = 0;
 
-    while((crt != NULL) && ((crt->children + (K - 1)) == prev)) {
-        prev = crt;
-        crt = crt->father;
+    if(nbLeftLeaves < nbLeaves)
+        nbLeaves = nbLeftLeaves;
+
+    if(nbLeaves > (ROUND_SIZE * instance->nbThreads))
+        nbLeaves = ROUND_SIZE * instance->nbThreads;
+
+    if((instance->maxNbNodes > 0) && (((K * (instance->nextOpennedNode + nbLeaves)) + 1) > instance->maxNbNodes)) {
+        size_t nbRoomLeaves = (instance->maxNbNodes - 1) / K;                              // The round stops at the leaf the sequential planning would stop at
+
+        nbLeaves = nbRoomLeaves > instance->nextOpennedNode ? nbRoomLeaves - instance->nextOpennedNode : 0;
+        instance->isMemoryFull = 1;
     }
 
-    if(crt == NULL) {
-        crt = instance->root;
-        instance->crtDepth++;
+    if((nbLeaves == 0) || !reserveNodes(instance, (K * (instance->nextOpennedNode + nbLeaves)) + 1)) {
+        instance->isMemoryFull = 1;
+        return;
+    }
+
+    instance->roundStart = instance->nextOpennedNode;
+    instance->roundSize = nbLeaves;
+    instance->taskSize = (nbLeaves + instance->nbThreads - 1) / instance->nbThreads;
+
+    thread_pool_run(instance->threads, openLeaves, instance, (nbLeaves + instance->taskSize - 1) / instance->taskSize);
+
+    if(instance->table != NULL) {
+        for(; i < nbLeaves; i++) {
+            if(instance->isSimulated[i])
+                STATS_TIME(&instance->stats, bookkeepingTime, insertChildren(instance, instance->roundStart + i, instance->roundResults + (i * K)));
+        }
+    }
+
+    skipLeaves(instance, nbLeaves);
+
+}
+
+
+/* The leaves are numbered from left to right: the children of the openned nodes of depth crtDepth, which are the last
+ * nodes, then the nodes of depth crtDepth not openned yet. */
+static size_t getNbLeaves(uniform_instance* instance) {
+
+    return (instance->crtNbEvaluations + 1) - instance->nextOpennedNode;
+
+}
+
+
+/* Returns the first leaf of the best discounted sum among the leaves numbered from first to end - 1. */
+static size_t findOptimalLeaf(uniform_instance* instance, size_t first, size_t end) {
+
+    size_t nextLevelStart = instance->crtLevelStart + instance->crtLevelSize;
+    size_t nbLastLeaves = (instance->crtNbEvaluations + 1) - nextLevelStart;
+    size_t optimalLeaf = first < nbLastLeaves ? nextLevelStart + first : instance->nextOpennedNode + (first - nbLastLeaves);
+    size_t i = first;
+
+    for(; i < end; i++) {
+        size_t leaf = i < nbLastLeaves ? nextLevelStart + i : instance->nextOpennedNode + (i - nbLastLeaves);
+
+        if(instance->discountedSums[leaf] > instance->discountedSums[optimalLeaf])
+            optimalLeaf = leaf;
+    }
+
+    return optimalLeaf;
+
+}
+
+
+static void findTaskOptimalLeaf(void* data, unsigned int taskId) {
+
+    uniform_instance* instance = (uniform_instance*)data;
+    size_t first = taskId * instance->taskSize;
+    size_t end = (first + instance->taskSize) < instance->roundSize ? first + instance->taskSize : instance->roundSize;
+
+    instance->optimalLeaves[taskId] = findOptimalLeaf(instance, first, end);
+
+}
+
+
+/* On several threads, each task scans a range of the leaves and their best leaves are compared in the order of the
+ * ranges, which keeps the first best leaf. */
+static void updateOptimalLeaf(uniform_instance* instance) {
+
+    size_t nbLeaves = getNbLeaves(instance);
+    size_t crt = 0;
+
+    if(instance->threads == NULL) {
+        instance->crtOptimalLeaf = findOptimalLeaf(instance, 0, nbLeaves);
     } else {
-        crt = crt->children + prev->id + 1;
+        unsigned int nbTasks = 0;
+        unsigned int i = 1;
+
+        instance->roundSize = nbLeaves;
+        instance->taskSize = (nbLeaves + instance->nbThreads - 1) / instance->nbThreads;
+        nbTasks = (nbLeaves + instance->taskSize - 1) / instance->taskSize;
+
+        thread_pool_run(instance->threads, findTaskOptimalLeaf, instance, nbTasks);
+
+        instance->crtOptimalLeaf = instance->optimalLeaves[0];
+
+        for(; i < nbTasks; i++) {
+            if(instance->discountedSums[instance->optimalLeaves[i]] > instance->discountedSums[instance->crtOptimalLeaf])
+                instance->crtOptimalLeaf = instance->optimalLeaves[i];
+        }
     }
 
-    while(crt->children != NULL)
-        crt = crt->children;
+    crt = instance->crtOptimalLeaf;
 
-    instance->nextOpennedNode = crt;
+    while(crt > K)
+        crt = (crt - 1) / K;
+
+    instance->trajectoryId = crt > 0 ? crt - 1 : 0;
 
 }
 
 
-static void buildingTrajectory(uniform_instance* instance) {
+/* Makes room in the stack for the nodes of depth 0 to nbDepths - 1 of a path. */
+static void reserveStack(uniform_instance* instance, unsigned int nbDepths) {
+
+    if(nbDepths > instance->stackSize) {
+        instance->stackSize = nbDepths;
+        instance->stackStates = (char*)realloc(instance->stackStates, instance->stateSize * K * nbDepths);
+        instance->stackRewards = (double*)realloc(instance->stackRewards, sizeof(double) * K * nbDepths);
+        instance->stackSums = (double*)realloc(instance->stackSums, sizeof(double) * (nbDepths + 1));
+        instance->stackIds = (unsigned int*)realloc(instance->stackIds, sizeof(unsigned int) * (nbDepths + 1));
+        STATS_ADD(&instance->stats, nbAllocations, 4);
+    }
+
+}
+
+
+static void lookupOrSimulate(uniform_instance* instance, state* s, state* children, double* rewards) {
+
+    if((instance->table == NULL) || !transposition_lookup(instance->table, s, children, rewards, instance->results)) {
+        nextStatesRewardsInto(s, children, rewards, instance->results);
+
+        if(instance->table != NULL)
+            transposition_insert(instance->table, s, children, rewards, instance->results);
+    }
+
+}
 
-    uniform_node* n = instance->nextOpennedNode;
 
+/* Simulates the K children of s, the node of the path at depth depth, in the stack. */
+static void openPathNode(uniform_instance* instance, state* s, unsigned int depth) {
+
+    state* children = (state*)(instance->stackStates + (depth * K * instance->stateSize));
+    double* rewards = instance->stackRewards + (depth * K);
+
+    STATS_TIME(&instance->stats, simulationTime, lookupOrSimulate(instance, s, children, rewards));
+
+    instance->crtNbEvaluations += K;
+    instance->totalNbEvaluations += K;
+    instance->realNbEvaluations += K;
+
+}
+
+
+/* Enumerates depth-first the tree the stored planning would build from the root with maxNbEvaluations: complete down to
+ * crtDepth, with the nbOpennedLeaves first leaves of depth crtDepth openned. Only the path to the current node is kept,
+ * and the discounted sums are computed the same way, so that the best first action is the same. Returns 0 if the
+ * deadline was over before the end, 1 else. */
+static char enumerateTree(uniform_instance* instance, unsigned int maxNbEvaluations) {
+
+    size_t nbLeftLeaves = (maxNbEvaluations + K - 1) / K;                                  // As many leaves as the stored planning would open...
+    size_t levelSize = 1;
+    size_t nbLeaves = 0;
+    const double* gammaPowers = NULL;
+    unsigned int depth = 1;
     unsigned int i = 0;
 
-    n->children = (uniform_node*)malloc(K * sizeof(uniform_node));
+    instance->crtNbEvaluations = 0;
+    instance->crtDepth = 0;
+
+    while((nbLeftLeaves >= levelSize) && (instance->crtDepth < (instance->maxDepth - 1))) { // ...first as many complete levels as possible...
+        nbLeftLeaves -= levelSize;
+        levelSize *= K;
+        instance->crtDepth++;
+    }
+
+    instance->nbOpennedLeaves = instance->crtDepth < (instance->maxDepth - 1) ? nbLeftLeaves : 0; // ...then the first leaves of the next one
 
-    n->crtOptimalLeaf = n->children;
-    n->trajectoryId = 0;    
+    for(; i < K; i++)
+        instance->QValues[i] = -HUGE_VAL;
+    instance->trajectoryId = 0;
 
-    for(;i < K; i++) {
-        (n->children[i]).id = i;
-        (n->children[i]).trajectoryId = 0;
+    if(instance->crtDepth == 0)
+        return 1;
 
-        nextStateReward(n->s, actions[i], &((n->children[i]).s), &((n->children[i]).reward));
-        instance->crtNbEvaluations++;
-        instance->totalNbEvaluations++;
-        instance->realNbEvaluations++;
+    reserveStack(instance, instance->crtDepth + 1);
+    gammaPowers = discount_getPowers(instance->discount, instance->crtDepth + 1);
 
-        (n->children[i]).discountedSum = n->discountedSum + (instance->gammaPowers[instance->crtDepth] *  (n->children[i]).reward);
+    openPathNode(instance, (state*)instance->states, 0);
+    instance->stackSums[0] = 0.0;
+    instance->stackIds[1] = 0;
 
-        if((n->children[i]).discountedSum > n->crtOptimalLeaf->discountedSum) {
-            n->crtOptimalLeaf = n->children + i;
-            n->trajectoryId = i;
+    while(depth > 0) {
+        unsigned int id = instance->stackIds[depth];
+        double* sum = instance->stackSums + depth;
+
+        if(id == K) {                                                                       // Every child was visited: back to the father
+            depth--;
+            instance->stackIds[depth]++;
+            continue;
         }
 
-        (n->children[i]).children = NULL;
-        (n->children[i]).father = n;
+        *sum = instance->stackSums[depth - 1] + (gammaPowers[depth - 1] * instance->stackRewards[((depth - 1) * K) + id]);
 
-        (n->children[i]).crtOptimalLeaf = n->children + i;
-    }
+        if(((depth < instance->crtDepth) || (nbLeaves < instance->nbOpennedLeaves)) && deadline_isOver(&instance->clock))
+            return 0;
+
+        if(depth < instance->crtDepth) {
+            openPathNode(instance, (state*)(instance->stackStates + ((((depth - 1) * K) + id) * instance->stateSize)), depth);
+            depth++;
+            instance->stackIds[depth] = 0;
+            continue;
+        }
+
+        if(nbLeaves < instance->nbOpennedLeaves) {                                         // An openned leaf: its children are the leaves
+            openPathNode(instance, (state*)(instance->stackStates + ((((depth - 1) * K) + id) * instance->stateSize)), depth);
 
-    n = n->father;
+            for(i = 0; i < K; i++) {
+                double childSum = *sum + (gammaPowers[depth] * instance->stackRewards[(depth * K) + i]);
 
-    while(n != NULL) {
-        n->crtOptimalLeaf = n->children->crtOptimalLeaf;
-        n->trajectoryId = 0;
-        for(i = 1; i < K; i++) {
-            if((n->children[i]).crtOptimalLeaf->discountedSum > n->crtOptimalLeaf->discountedSum) {
-                n->crtOptimalLeaf = (n->children[i]).crtOptimalLeaf;
-                n->trajectoryId = i;
+                if(childSum > instance->QValues[instance->stackIds[1]])
+                    instance->QValues[instance->stackIds[1]] = childSum;
             }
+        } else if(*sum > instance->QValues[instance->stackIds[1]]) {
+            instance->QValues[instance->stackIds[1]] = *sum;
         }
 
-        n = n->father;
+        nbLeaves++;
+        instance->stackIds[depth]++;
     }
 
-    updateNextOpennedNode(instance);
+    for(i = 1; i < K; i++) {                                                                // The first best child is the one of the first best leaf
+        if(instance->QValues[i] > instance->QValues[instance->trajectoryId])
+            instance->trajectoryId = i;
+    }
+
+    return 1;
+
+}
+
+
+/* The tree a budget gives can not be enumerated in part: before a deadline, the trees of the budgets of one, two, ...
+ * complete levels are enumerated in turn, up to maxNbEvaluations, and the last one enumerated to the end is kept. */
+static void enumerateTreeUntilDeadline(uniform_instance* instance, unsigned int maxNbEvaluations) {
+
+    double* QValues = (double*)malloc(sizeof(double) * K);
+    unsigned int nbEvaluations = K < maxNbEvaluations ? K : maxNbEvaluations;
+    unsigned int crtNbEvaluations = 0;
+    unsigned int crtDepth = 0;
+    size_t nbOpennedLeaves = 0;
+    unsigned int trajectoryId = 0;
+    unsigned int i = 0;
+
+    for(; i < K; i++)
+        QValues[i] = -HUGE_VAL;
+
+    while(1) {
+        if(!enumerateTree(instance, nbEvaluations)) {                                           // Back to the last tree enumerated to the end
+            memcpy(instance->QValues, QValues, sizeof(double) * K);
+            instance->crtNbEvaluations = crtNbEvaluations;
+            instance->crtDepth = crtDepth;
+            instance->nbOpennedLeaves = nbOpennedLeaves;
+            instance->trajectoryId = trajectoryId;
+            break;
+        }
+
+        if((nbEvaluations == maxNbEvaluations) || (instance->crtDepth == crtDepth))             // The budget or the depth limit is reached
+            break;
+
+        memcpy(QValues, instance->QValues, sizeof(double) * K);
+        crtNbEvaluations = instance->crtNbEvaluations;
+        crtDepth = instance->crtDepth;
+        nbOpennedLeaves = instance->nbOpennedLeaves;
+        trajectoryId = instance->trajectoryId;
+
+        nbEvaluations = nbEvaluations < (maxNbEvaluations / K) ? K * (nbEvaluations + 1) : maxNbEvaluations;
+    }
+
+    free(QValues);
 
 }
 
@@ -205,109 +545,194 @@ static void buildingTrajectory(uniform_instance* instance) {
 action* uniform_planning(uniform_instance* instance, unsigned int maxNbEvaluations) {
 
     instance->realNbEvaluations = 0;
+    instance->isMemoryFull = 0;
+
+    if(instance->isDepthFirst) {
+        if(instance->clock.deadline > 0)
+            enumerateTreeUntilDeadline(instance, maxNbEvaluations);
+        else
+            enumerateTree(instance, maxNbEvaluations);
 
-    while((instance->crtNbEvaluations < maxNbEvaluations) && (instance->crtDepth < (UNIFORM_MAX_DEPTH - 1)))
-        buildingTrajectory(instance);
+        STATS_SET(&instance->stats, nbNodes, (K * instance->stackSize) + 1);                    // Only the path is stored
+        STATS_SET(&instance->stats, maxDepth, uniform_getMaxDepth(instance));
 
-    return actions[instance->root->trajectoryId];
+        return actions[instance->trajectoryId];
+    }
+
+    while((instance->crtNbEvaluations < maxNbEvaluations) && (instance->crtDepth < (instance->maxDepth - 1)) && !instance->isMemoryFull && !deadline_isOver(&instance->clock)) {
+        if(instance->threads != NULL)
+            buildingLevel(instance, maxNbEvaluations);
+        else
+            buildingTrajectory(instance);
+    }
+
+    STATS_TIME(&instance->stats, bookkeepingTime, updateOptimalLeaf(instance));
+    STATS_SET(&instance->stats, nbNodes, instance->crtNbEvaluations + 1);
+    STATS_SET(&instance->stats, maxDepth, uniform_getMaxDepth(instance));
+
+    return actions[instance->trajectoryId];
 
 }
 
 
-static void updateValues(uniform_instance* instance) {
+/* Same as uniform_planning, but also stops at deadline, in nanoseconds on the clock of deadline_now, and then returns the
+ * best action found so far. The leaves of a stored tree are still scanned for the best one once it is over. The number of
+ * evaluations done is in realNbEvaluations. */
+action* uniform_planningDeadline(uniform_instance* instance, unsigned int maxNbEvaluations, uint64_t deadline) {
 
-    unsigned int crtDepth = 1;
-    unsigned int crtMaxDepth = 1;
+    action* a = NULL;
 
-    uniform_node* crt = instance->root->children;
+    deadline_start(&instance->clock, deadline);
+    a = uniform_planning(instance, maxNbEvaluations);
+    deadline_start(&instance->clock, 0);
 
-    while(1) {
-        while(crt->children != NULL) {
-            crt->discountedSum = crt->father->discountedSum + (instance->gammaPowers[crtDepth - 1] * crt->reward);
-            crtDepth++;
-            instance->crtNbEvaluations++;
-            crt = crt->children;
-        }
+    return a;
+
+}
 
-        instance->crtNbEvaluations++;
-        crt->discountedSum = crt->father->discountedSum + (instance->gammaPowers[crtDepth - 1] * crt->reward);
 
-        if(crtDepth >= crtMaxDepth) {
-            crtMaxDepth = crtDepth;
-            instance->nextOpennedNode = crt->father;
+/* The nodes of the kept subtree are contiguous on each level: they are moved level by level to the front of the arrays,
+ * where the level above was, which does not overlap the levels still to move. */
+static void keepSubtree(uniform_instance* instance) {
+
+    if(instance->isDepthFirst) {                                                            // Nothing is kept but the state of the new root
+        if(instance->crtDepth > 0)
+            memcpy(instance->states, instance->stackStates + (instance->trajectoryId * instance->stateSize), instance->stateSize);
+    } else if(instance->crtNbEvaluations > 0) {
+        size_t nbNodes = instance->crtNbEvaluations + 1;
+        size_t nbKeptNodes = 0;
+        size_t levelStart = 1;                                                              // First node of the level the kept nodes are moved from...
+        size_t branchSize = 1;                                                              // ...and how many of its nodes are below the kept child
+        size_t newLevelStart = 0;
+
+        while((levelStart + (instance->trajectoryId * branchSize)) < nbNodes) {
+            size_t first = levelStart + (instance->trajectoryId * branchSize);
+            size_t nbKept = (first + branchSize) <= nbNodes ? branchSize : nbNodes - first; // Only the deepest level may not be complete
+
+            memmove(instance->discountedSums + newLevelStart, instance->discountedSums + first, sizeof(double) * nbKept);
+            memmove(instance->rewards + newLevelStart, instance->rewards + first, sizeof(double) * nbKept);
+            memmove(instance->states + (newLevelStart * instance->stateSize), instance->states + (first * instance->stateSize), instance->stateSize * nbKept);
+            nbKeptNodes += nbKept;
+
+            newLevelStart = levelStart;
+            levelStart += K * branchSize;
+            branchSize *= K;
         }
 
-        while(crt && (crt->id >= (K - 1))) {
-            crtDepth--;
-            crt = crt->father;
+        instance->crtNbEvaluations = nbKeptNodes - 1;                                       // The discounted sums below stay the ones from the previous roots
+        instance->rootDepth++;
+
+        if(instance->crtNbEvaluations == 0) {
+            instance->discountedSums[0] = 0.0;
+            instance->rootDepth = 0;
+        } else if((instance->rootDepth >= instance->maxDepth) || (discount_getPowers(instance->discount, instance->rootDepth + 1)[instance->rootDepth] < MIN_ROOT_GAMMA_POWER)) {
+            STATS_TIME(&instance->stats, updateValuesTime, crtKernel->updateValues(instance));
         }
 
-        if(crt)
-            crt = crt->father->children + crt->id + 1;
-        else
-            break;
+        setNextOpennedNode(instance);                                                       // The level being openned goes on in the kept subtree, if it got there
     }
 
-    instance->crtDepth = crtMaxDepth;
-
 }
 
 
 void uniform_keepSubtree(uniform_instance* instance) {
 
-    if(instance->root->children) {
-        unsigned int i = 0;
-        unsigned int keptSubtreeId = instance->root->trajectoryId;
-        uniform_node* cuttedSubtrees = instance->root->children;
-
-        freeState(instance->root->s);
-        instance->root->s = (cuttedSubtrees[keptSubtreeId]).s;
-        instance->root->trajectoryId = (cuttedSubtrees[keptSubtreeId]).trajectoryId;
-        instance->root->children = (cuttedSubtrees[keptSubtreeId]).children;
-
-        for(; i < keptSubtreeId; i++)
-            deleteTree(cuttedSubtrees + i);
-        for(i = keptSubtreeId + 1; i < K; i++)
-            deleteTree(cuttedSubtrees + i);
-        free(cuttedSubtrees);
-        
-        instance->crtNbEvaluations = 0;
-
-        if(instance->root->children == NULL) {
-            instance->root->crtOptimalLeaf = instance->root;
-            instance->nextOpennedNode = instance->root;
-            instance->crtDepth = 0;
-        } else {
-            for(i = 0; i < K; i++)
-                (instance->root->children[i]).father = instance->root;
-            updateValues(instance);
-            updateNextOpennedNode(instance);
-        }
+    STATS_TIME(&instance->stats, keepSubtreeTime, keepSubtree(instance));
 
-        //printf("%u evaluations kept\n", instance->crtNbEvaluations);
-    }
 }
 
 
-unsigned int uniform_getMaxDepth(uniform_instance* instance) {
+/* Bounds the memory taken by the nodes below the root, their states included, to maxNbBytes (0 for no bound). A
+ * planning reaching it stops. */
+void uniform_setMemoryLimit(uniform_instance* instance, size_t maxNbBytes) {
+
+    instance->maxNbNodes = maxNbBytes > 0 ? (maxNbBytes / ((2 * sizeof(double)) + instance->stateSize)) + 1 : 0;
+
+}
+
+
+/* The children of the nodes are looked up in table, if it is not NULL, before being simulated, and the ones simulated
+ * are added to it. The table is not released with the instance. */
+void uniform_setTranspositionTable(uniform_instance* instance, transposition_table* table) {
 
-    uniform_node* crt = instance->root;
-    unsigned int depth = 0;
+    instance->table = table;
 
-    while(crt && (crt->children != NULL)) {
-        crt = crt->children;
-        depth++;
+}
+
+
+/* Opens the leaves of each level on nbThreads threads if there are more than one, by rounds of at most ROUND_SIZE leaves
+ * per thread. The tree is the same as the sequential planning would build, except that the children simulated in a
+ * round are only added to the transposition table at its end. */
+void uniform_setThreads(uniform_instance* instance, unsigned int nbThreads) {
+
+    if(instance->threads != NULL) {
+        thread_pool_uninit(&instance->threads);
+        free(instance->roundResults);
+        free(instance->isSimulated);
+        free(instance->optimalLeaves);
+        instance->roundResults = NULL;
+        instance->isSimulated = NULL;
+        instance->optimalLeaves = NULL;
+    }
+
+    instance->nbThreads = nbThreads > 0 ? nbThreads : 1;
+
+    if(instance->nbThreads > 1) {
+        instance->threads = thread_pool_init(instance->nbThreads);
+        instance->roundResults = (char*)malloc(sizeof(char) * K * ROUND_SIZE * instance->nbThreads);
+        instance->isSimulated = (char*)malloc(sizeof(char) * ROUND_SIZE * instance->nbThreads);
+        instance->optimalLeaves = (size_t*)malloc(sizeof(size_t) * instance->nbThreads);
     }
 
-    return depth;
+}
+
+
+/* In depth-first mode, the tree is enumerated by each planning without being stored: the memory taken only grows with
+ * its depth. The planning is then sequential and keeping a subtree only keeps the state of its root. */
+void uniform_setDepthFirst(uniform_instance* instance, char isDepthFirst) {
+
+    instance->isDepthFirst = isDepthFirst;
+
+    instance->crtNbEvaluations = 0;                                                         // Either way, the tree starts over from the root
+    instance->rootDepth = 0;
+    instance->discountedSums[0] = 0.0;
+    setNextOpennedNode(instance);
+
+}
+
+
+/* The tree is not openned deeper than maxDepth - 1, UNIFORM_MAX_DEPTH - 1 by default. */
+void uniform_setMaxDepth(uniform_instance* instance, unsigned int maxDepth) {
+
+    instance->maxDepth = maxDepth > 1 ? maxDepth : 2;
+
+}
+
+
+unsigned int uniform_getMaxDepth(uniform_instance* instance) {
+
+    if(instance->isDepthFirst)
+        return instance->nbOpennedLeaves > 0 ? instance->crtDepth + 1 : instance->crtDepth;
+
+    return instance->nextOpennedNode > instance->crtLevelStart ? instance->crtDepth + 1 : instance->crtDepth;
 
 }
 
 
 void uniform_uninitInstance(uniform_instance** instance) {
 
-    deleteTree((*instance)->root);
-    free((*instance)->root);
+    uniform_setThreads(*instance, 1);
+
+    free((*instance)->discountedSums);
+    free((*instance)->rewards);
+    free((*instance)->states);
+    free((*instance)->results);
+    free((*instance)->QValues);
+    free((*instance)->stackStates);
+    free((*instance)->stackRewards);
+    free((*instance)->stackSums);
+    free((*instance)->stackIds);
+    discount_releaseTable(&(*instance)->discount);
 
     free((*instance));
     *instance = NULL;
@@ -35,39 +35,76 @@
 #ifndef UNIFORM_H
 #define UNIFORM_H
 
-#ifdef LIMITED_DEPTH
-#define UNIFORM_MAX_DEPTH 512
-#else
-#define UNIFORM_MAX_DEPTH 32768
-#endif
+#define UNIFORM_MAX_DEPTH 32768         // Default depth limit of the tree
 
 #include "../../problems/generative_model.h"
+#include "../transposition/transposition.h"
+#include "../thread_pool/thread_pool.h"
+#include "../discount/discount.h"
+#include "../deadline/deadline.h"
+#include "../stats/stats.h"
 
-typedef struct uniform_node_struct {
-        state* s;
-        double reward;
-        unsigned int id;
-        double discountedSum;
-        unsigned int trajectoryId;
-        struct uniform_node_struct* crtOptimalLeaf;
-        struct uniform_node_struct* father;
-        struct uniform_node_struct* children;
-}	uniform_node;
-
+/* The tree is complete down to crtDepth and its nodes are stored breadth-first in flat arrays: the root is node 0 and the
+ * children of node i are the nodes K * i + 1 to K * i + K. The leaves of depth crtDepth are openned from left to right,
+ * so the nodes are openned in the order they are stored and node i is openned if and only if K * i + 1 is a node.
+ *
+ * The discounted sums are the ones from the root the instance was reset on: keeping a subtree only scales and shifts
+ * them all the same way, so that the nodes below the new root are left as they are until the power of gamma at the
+ * depth of the root gets too small. */
 typedef struct {
 
         double gamma;
-        uniform_node* root;
 
-        unsigned int crtNbEvaluations;
+        double* discountedSums;
+        double* rewards;
+        char* states;                       // stateSize bytes per node
+        size_t capacity;                    // Number of nodes the arrays have room for
+        size_t maxNbNodes;                  // Number of nodes the memory limit leaves room for. 0 if there is no limit
+
+        unsigned int crtNbEvaluations;      // Number of nodes below the root
         unsigned int realNbEvaluations;
         unsigned int totalNbEvaluations;
 
         unsigned int crtDepth;
+        unsigned int rootDepth;             // Depth of the root in the tree the discounted sums are from
+
+        discount_table* discount;           // Shared by the instances of the same discount factor
+        unsigned int maxDepth;              // Neither the tree nor the depth of the root go deeper than maxDepth - 1
+
+        size_t crtLevelStart;               // First node of depth crtDepth
+        size_t crtLevelSize;                // Number of nodes of depth crtDepth
+        size_t nextOpennedNode;
+
+        size_t crtOptimalLeaf;              // Leftmost leaf of the best discounted sum at the end of the last planning
+        unsigned int trajectoryId;          // The child of the root crtOptimalLeaf descends from
+
+        size_t stateSize;                   // Size of a state of the generative model
+        char* results;                      // The K results of the last expansion
+
+        char isMemoryFull;                  // 1 if the last planning stopped at the memory limit, 0 else
+
+        transposition_table* table;         // Where the children of a node are looked up before being simulated. NULL if there is none
+
+        thread_pool* threads;               // Threads openning the leaves of a level at the same time. NULL if the planning is sequential
+        unsigned int nbThreads;
+        size_t roundStart;                  // First leaf of the current parallel round
+        size_t roundSize;                   // Number of leaves of the current parallel round
+        size_t taskSize;                    // Number of leaves each task of the round opens, or scans for the best leaf
+        char* roundResults;                 // The K results of each leaf of the round
+        char* isSimulated;                  // 1 for the leaves of the round whose children missed the transposition table, 0 else
+        size_t* optimalLeaves;              // The best leaf found by each task of the scan
 
-        double gammaPowers[UNIFORM_MAX_DEPTH];
+        char isDepthFirst;                  // 1 if the tree is enumerated depth-first instead of being stored, 0 else
+        double* QValues;                    // In depth-first mode, the best discounted sum below each child of the root
+        size_t nbOpennedLeaves;             // In depth-first mode, the number of leaves of depth crtDepth that are openned
+        unsigned int stackSize;             // Number of depths the stack of the depth-first mode has room for
+        char* stackStates;                  // For each depth of the current path, the K children of its node...
+        double* stackRewards;               // ...and their rewards
+        double* stackSums;                  // The discounted sum of the node of each depth of the current path
+        unsigned int* stackIds;             // The index of the node of each depth of the current path among its brothers
 
-        uniform_node* nextOpennedNode;
+        deadline_clock clock;               // Deadline of the planning being done, if it has one
+        stats_counters stats;               // Where the time of the plannings goes, counted when built with USE_STATS
 
 }   uniform_instance;
 
@@ -75,7 +112,13 @@ typedef struct {
 uniform_instance* uniform_initInstance(state* initial, double discountFactor);
 void uniform_resetInstance(uniform_instance* instance, state* initial);
 action* uniform_planning(uniform_instance* instance, unsigned int maxNbEvaluations);
+action* uniform_planningDeadline(uniform_instance* instance, unsigned int maxNbEvaluations, uint64_t deadline);
 void uniform_keepSubtree(uniform_instance* instance);
+void uniform_setMemoryLimit(uniform_instance* instance, size_t maxNbBytes);
+void uniform_setTranspositionTable(uniform_instance* instance, transposition_table* table);
+void uniform_setThreads(uniform_instance* instance, unsigned int nbThreads);
+void uniform_setDepthFirst(uniform_instance* instance, char isDepthFirst);
+void uniform_setMaxDepth(uniform_instance* instance, unsigned int maxDepth);
 unsigned int uniform_getMaxDepth(uniform_instance* instance);
 void uniform_uninitInstance(uniform_instance** instance);
 
@@ -41,9 +41,9 @@
 
 #include "uniform.h"
 
-static void drawTree(SDL_Surface* screen, uniform_node* n, double start, double stop, unsigned int depth, double hSpaceTree) {
+static void drawTree(SDL_Surface* screen, uniform_instance* instance, size_t n, double start, double stop, unsigned int depth, double hSpaceTree) {
 
-    if(n->children != NULL) {
+    if(((K * n) + 1) <= instance->crtNbEvaluations) {
         unsigned int i = 0, depthChild = depth + 1;
         double spaceBetween = (stop - start) / K;
         double startChild, stopChild;
@@ -51,7 +51,7 @@ static void drawTree(SDL_Surface* screen, uniform_node* n, double start, double
         for(; i < K; i++) {
             startChild = start + (i * spaceBetween);
             stopChild = startChild + spaceBetween;
-            drawTree(screen, n->children + i, startChild, stopChild, depthChild, hSpaceTree);
+            drawTree(screen, instance, (K * n) + 1 + i, startChild, stopChild, depthChild, hSpaceTree);
             aalineRGBA(screen, start + ((stop-start) / 2), depth * hSpaceTree, startChild + (spaceBetween / 2), depthChild * hSpaceTree , 0, 0, 0, 255);
         }
     }
@@ -65,19 +65,15 @@ void uniform_drawingProcedure(SDL_Surface* screen, int screenWidth, int screenHe
     static double hSpaceTree = 10.0;
 
     if(instance == NULL) {
-        uniform_node* root = ((uniform_instance*)instance)->root;
+        unsigned int crtMaxDepth = uniform_getMaxDepth((uniform_instance*)instance);
 
-        if(root != NULL) {
-            unsigned int crtMaxDepth = uniform_getMaxDepth((uniform_instance*)instance);
-            
-            if(crtMaxDepth > maxViewedDepth) {
-                maxViewedDepth = crtMaxDepth;
-                hSpaceTree = screenHeight / maxViewedDepth;
-                printf("maxViewedDepth: %u\n", maxViewedDepth);
-            }
+        if(crtMaxDepth > maxViewedDepth) {
+            maxViewedDepth = crtMaxDepth;
+            hSpaceTree = screenHeight / maxViewedDepth;
+            printf("maxViewedDepth: %u\n", maxViewedDepth);
         }
 
-        drawTree(screen, root, screenWidth / 2.0, screenWidth, 0, hSpaceTree);
+        drawTree(screen, (uniform_instance*)instance, 0, screenWidth / 2.0, screenWidth, 0, hSpaceTree);
     }
 
 }
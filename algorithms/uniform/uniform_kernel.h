@@ -0,0 +1,89 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+/* The loops of the uniform planning over the children of a node, compiled by uniform.c once per branching factor
+ * through ../kernel/kernel.h. */
+
+/* Simulates the K children of node n, unless they are found in the transposition table, and sets their discounted sums.
+ * Their results are written in results. Returns 1 if they were simulated, 0 else. */
+static char KERNEL(simulateChildren)(uniform_instance* instance, size_t n, char* results) {
+
+    size_t children = (KERNEL_K * n) + 1;
+    state* s = (state*)(instance->states + (n * instance->stateSize));
+    state* childrenStates = (state*)(instance->states + (children * instance->stateSize));
+    unsigned int depth = instance->rootDepth + instance->crtDepth;
+    double gammaPower = discount_getPowers(instance->discount, depth + 1)[depth];
+    char isSimulated = 0;
+    unsigned int i = 0;
+
+    if((instance->table == NULL) || !transposition_lookup(instance->table, s, childrenStates, instance->rewards + children, results)) {
+        nextStatesRewardsInto(s, childrenStates, instance->rewards + children, results);  // The children are simulated at once
+        isSimulated = 1;
+    }
+
+    for(; i < KERNEL_K; i++)
+        instance->discountedSums[children + i] = instance->discountedSums[n] + (gammaPower * instance->rewards[children + i]);
+
+    return isSimulated;
+
+}
+
+
+/* Rebases the discounted sums on the root. */
+static void KERNEL(updateValues)(uniform_instance* instance) {
+
+    size_t nbNodes = instance->crtNbEvaluations + 1;
+    size_t levelEnd = 1;
+    size_t levelSize = 1;
+    const double* gammaPowers = discount_getPowers(instance->discount, instance->crtDepth + 1);
+    unsigned int crtDepth = 0;
+    size_t i = 1;
+
+    instance->discountedSums[0] = 0.0;
+    instance->rootDepth = 0;
+
+    for(; i < nbNodes; i++) {
+        if(i == levelEnd) {
+            levelSize *= KERNEL_K;
+            levelEnd += levelSize;
+            crtDepth++;
+        }
+
+        instance->discountedSums[i] = instance->discountedSums[(i - 1) / KERNEL_K] + (gammaPowers[crtDepth - 1] * instance->rewards[i]);
+    }
+
+}
+
+
+static const uniform_kernel KERNEL(kernel) = {KERNEL(simulateChildren), KERNEL(updateValues)};
@@ -40,6 +40,7 @@
 #include <string.h>
 
 #include "acrobot.h"
+#include "../simd.h"
 
 unsigned int K = 2;                             //Number of actions that can be applied in a state
 double timeStep = 0.1;                          //Time step between two state
@@ -48,6 +49,7 @@ action** actions = NULL;                        //Array of action
 
 double* parameters = NULL;                      //Model's parameters
 unsigned int nbParameters = 9;                  //Number of model's parameters
+uint64_t modelSeed = 0;                         //Seed of the random streams of the model
 
 /*+-----------------Model's parameters----------------+
   |                                                   |
@@ -186,11 +188,11 @@ state* initState() {
 }
 
 
-/* Returns a triplet containing the next state, the applied action and the reward given the current state and action. */
+/* Writes the next state in nextState and returns the reward given the current state and action. */
 
-char nextStateReward(state* s, action* a, state** nextState,double* reward) {
+char nextStateRewardInto(state* s, action* a, state* nextState, double* reward) {
 
-    *nextState = copyState(s);
+    memcpy(nextState, s, sizeof(state));
 
     if(s->isTerminal < 0) {
         *reward = 0.0;
@@ -205,57 +207,198 @@ char nextStateReward(state* s, action* a, state** nextState,double* reward) {
         double l2 = parameters[3];
         double mu2 = parameters[5];
 
-        double a11 = ((4.0 / 3.0) * m1 + 4 * m2) * l1 * l1;
-        double a22 = (4.0 / 3.0) * m2 * l2 * l2;
-        double m2l2l12 = 2 * m2 * l1 * l2;
-        double coef1 = (m1 + 2 * m2) * l1 * 9.81;
+        double a11 = ((4.0 / 3.0) * m1 + 4 * m2) * l1 * l1;
+        double a22 = (4.0 / 3.0) * m2 * l2 * l2;
+        double m2l2l12 = 2 * m2 * l1 * l2;
+        double coef1 = (m1 + 2 * m2) * l1 * 9.81;
         double coef2 = m2 * l2 * 9.81;
 
-        double a12 = m2l2l12 * cos((*nextState)->angularPosition2 - (*nextState)->angularPosition1);
-        double Det = a11 * a22 - a12 * a12;
-
-        double s = sin((*nextState)->angularPosition2 - (*nextState)->angularPosition1);
-        double b1 = coef1 * sin((*nextState)->angularPosition1) + m2l2l12 * (*nextState)->angularVelocity2 * (*nextState)->angularVelocity2 * s - a->torque - mu1 * (*nextState)->angularVelocity1;
-        double b2 = coef2 * sin((*nextState)->angularPosition2) - m2l2l12 * (*nextState)->angularVelocity1 * (*nextState)->angularVelocity1 * s + a->torque - mu2 * (*nextState)->angularVelocity2;
-
-        (*nextState)->angularPosition1 += (*nextState)->angularVelocity1 * timeStep;  
-        (*nextState)->angularPosition2 += (*nextState)->angularVelocity2 * timeStep;
-        (*nextState)->angularVelocity1 += ((a22 * b1 - a12 * b2) / Det) * timeStep;
-        (*nextState)->angularVelocity2 += ((-a12 * b1 + a11 * b2) / Det) * timeStep;
+        double a12 = m2l2l12 * cos(nextState->angularPosition2 - nextState->angularPosition1);
+        double Det = a11 * a22 - a12 * a12;
 
-        if((*nextState)->angularVelocity1 > parameters[8])
-            (*nextState)->angularVelocity1 = parameters[8];
+        double s = sin(nextState->angularPosition2 - nextState->angularPosition1);
+        double b1 = coef1 * sin(nextState->angularPosition1) + m2l2l12 * nextState->angularVelocity2 * nextState->angularVelocity2 * s - a->torque - mu1 * nextState->angularVelocity1;
+        double b2 = coef2 * sin(nextState->angularPosition2) - m2l2l12 * nextState->angularVelocity1 * nextState->angularVelocity1 * s + a->torque - mu2 * nextState->angularVelocity2;
 
-        if((*nextState)->angularVelocity1 < -parameters[8])
-            (*nextState)->angularVelocity1 = -parameters[8];
+        nextState->angularPosition1 += nextState->angularVelocity1 * timeStep;  
+        nextState->angularPosition2 += nextState->angularVelocity2 * timeStep;
+        nextState->angularVelocity1 += ((a22 * b1 - a12 * b2) / Det) * timeStep;
+        nextState->angularVelocity2 += ((-a12 * b1 + a11 * b2) / Det) * timeStep;
 
-        if((*nextState)->angularVelocity2 > parameters[8])
-            (*nextState)->angularVelocity2 = parameters[8];
+        if(nextState->angularVelocity1 > parameters[8])
+            nextState->angularVelocity1 = parameters[8];
 
-        if((*nextState)->angularVelocity2 < -parameters[8])
-            (*nextState)->angularVelocity2 = -parameters[8];
+        if(nextState->angularVelocity1 < -parameters[8])
+            nextState->angularVelocity1 = -parameters[8];
 
+        if(nextState->angularVelocity2 > parameters[8])
+            nextState->angularVelocity2 = parameters[8];
 
-        if((*nextState)->angularPosition1 > (2.0 * M_PIl))
-            (*nextState)->angularPosition1 -= 2.0 * M_PIl;
+        if(nextState->angularVelocity2 < -parameters[8])
+            nextState->angularVelocity2 = -parameters[8];
 
-        if((*nextState)->angularPosition1 < 0.0)
-            (*nextState)->angularPosition1 += 2.0 * M_PIl;
 
-        if((*nextState)->angularPosition2 > (2.0 * M_PIl))
-            (*nextState)->angularPosition2 -= 2.0 * M_PIl;
+        if(nextState->angularPosition1 > (2.0 * M_PIl))
+            nextState->angularPosition1 -= 2.0 * M_PIl;
 
-        if((*nextState)->angularPosition2 < 0.0)
-            (*nextState)->angularPosition2 += 2.0 * M_PIl;
+        if(nextState->angularPosition1 < 0.0)
+            nextState->angularPosition1 += 2.0 * M_PIl;
 
-        x = (sin((*nextState)->angularPosition1) * l1) + (sin((*nextState)->angularPosition2) * l2);
-        y = (cos((*nextState)->angularPosition1) * l1) + (cos((*nextState)->angularPosition2) * l2);
+        if(nextState->angularPosition2 > (2.0 * M_PIl))
+            nextState->angularPosition2 -= 2.0 * M_PIl;
+
+        if(nextState->angularPosition2 < 0.0)
+            nextState->angularPosition2 += 2.0 * M_PIl;
+
+        x = (sin(nextState->angularPosition1) * l1) + (sin(nextState->angularPosition2) * l2);
+        y = (cos(nextState->angularPosition1) * l1) + (cos(nextState->angularPosition2) * l2);
 
         *reward = 1.0 - (sqrt(((y - (l1 + l2)) * (y - (l1 + l2))) + (x * x)) / (2.0 * (l1 + l2)));
 
     }
 
-    return (*nextState)->isTerminal;
+    return nextState->isTerminal;
+
+}
+
+
+/* Returns an allocated next state and the reward given the current state and action. */
+
+char nextStateReward(state* s, action* a, state** nextState, double* reward) {
+
+    *nextState = (state*)malloc(sizeof(state));
+
+    return nextStateRewardInto(s, a, *nextState, reward);
+
+}
+
+
+/* Writes the next states and the rewards of the K actions at once. The torque only changes the velocities: the
+ * positions and the reward are computed once, the velocities SIMD_WIDTH actions at a time. */
+
+void nextStatesRewardsInto(state* s, state* nextStates, double* rewards, char* results) {
+
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    if(s->isTerminal < 0) {
+        for(; i < K; i++) {
+            memcpy(nextStates + i, s, sizeof(state));
+            rewards[i] = 0.0;
+            results[i] = s->isTerminal;
+        }
+    } else {
+        state next;
+        double x = 0.0;
+        double y = 0.0;
+        double reward = 0.0;
+
+        double m1 = parameters[1];
+        double l1 = parameters[0];
+        double mu1 = parameters[2];
+        double m2 = parameters[4];
+        double l2 = parameters[3];
+        double mu2 = parameters[5];
+
+        double a11 = ((4.0 / 3.0) * m1 + 4 * m2) * l1 * l1;
+        double a22 = (4.0 / 3.0) * m2 * l2 * l2;
+        double m2l2l12 = 2 * m2 * l1 * l2;
+        double coef1 = (m1 + 2 * m2) * l1 * 9.81;
+        double coef2 = m2 * l2 * 9.81;
+
+        double a12 = m2l2l12 * cos(s->angularPosition2 - s->angularPosition1);
+        double Det = a11 * a22 - a12 * a12;
+
+        double sinDifference = sin(s->angularPosition2 - s->angularPosition1);
+        simd_double b1Term = simd_set(coef1 * sin(s->angularPosition1) + m2l2l12 * s->angularVelocity2 * s->angularVelocity2 * sinDifference);
+        simd_double b2Term = simd_set(coef2 * sin(s->angularPosition2) - m2l2l12 * s->angularVelocity1 * s->angularVelocity1 * sinDifference);
+        double mu1Velocity1 = mu1 * s->angularVelocity1;
+        double mu2Velocity2 = mu2 * s->angularVelocity2;
+        simd_double maxVelocity = simd_set(parameters[8]);
+
+        memcpy(&next, s, sizeof(state));
+
+        next.angularPosition1 += next.angularVelocity1 * timeStep;
+        next.angularPosition2 += next.angularVelocity2 * timeStep;
+
+        if(next.angularPosition1 > (2.0 * M_PIl))
+            next.angularPosition1 -= 2.0 * M_PIl;
+
+        if(next.angularPosition1 < 0.0)
+            next.angularPosition1 += 2.0 * M_PIl;
+
+        if(next.angularPosition2 > (2.0 * M_PIl))
+            next.angularPosition2 -= 2.0 * M_PIl;
+
+        if(next.angularPosition2 < 0.0)
+            next.angularPosition2 += 2.0 * M_PIl;
+
+        x = (sin(next.angularPosition1) * l1) + (sin(next.angularPosition2) * l2);
+        y = (cos(next.angularPosition1) * l1) + (cos(next.angularPosition2) * l2);
+
+        reward = 1.0 - (sqrt(((y - (l1 + l2)) * (y - (l1 + l2))) + (x * x)) / (2.0 * (l1 + l2)));
+
+        for(; i < K; i += SIMD_WIDTH) {
+            simd_double torque;
+            simd_double b1;
+            simd_double b2;
+            simd_double angularVelocity1;
+            simd_double angularVelocity2;
+
+            for(j = 0; j < SIMD_WIDTH; j++)
+                torque[j] = actions[SIMD_ACTION(i, j)]->torque;
+
+            b1 = b1Term - torque - mu1Velocity1;
+            b2 = b2Term + torque - mu2Velocity2;
+
+            angularVelocity1 = s->angularVelocity1 + ((a22 * b1 - a12 * b2) / Det) * timeStep;
+            angularVelocity2 = s->angularVelocity2 + ((-a12 * b1 + a11 * b2) / Det) * timeStep;
+
+            angularVelocity1 = simd_select((simd_mask)(angularVelocity1 > maxVelocity), maxVelocity, angularVelocity1);
+            angularVelocity1 = simd_select((simd_mask)(angularVelocity1 < -maxVelocity), -maxVelocity, angularVelocity1);
+            angularVelocity2 = simd_select((simd_mask)(angularVelocity2 > maxVelocity), maxVelocity, angularVelocity2);
+            angularVelocity2 = simd_select((simd_mask)(angularVelocity2 < -maxVelocity), -maxVelocity, angularVelocity2);
+
+            for(j = 0; (j < SIMD_WIDTH) && ((i + j) < K); j++) {
+                memcpy(nextStates + i + j, &next, sizeof(state));
+                nextStates[i + j].angularVelocity1 = angularVelocity1[j];
+                nextStates[i + j].angularVelocity2 = angularVelocity2[j];
+                rewards[i + j] = reward;
+                results[i + j] = next.isTerminal;
+            }
+        }
+    }
+
+}
+
+
+/* Returns the size of a state. */
+
+size_t getStateSize() {
+
+    return sizeof(state);
+
+}
+
+
+/* Returns the number of values in the key of a state. */
+
+unsigned int getStateKeyLength() {
+
+    return 5;
+
+}
+
+
+/* Writes the key of s: its variables, rounded if quantum is greater than 0, and whether it is terminal. */
+
+void getStateKey(state* s, double quantum, double* key) {
+
+    key[0] = QUANTIZE(s->angularPosition1, quantum);
+    key[1] = QUANTIZE(s->angularVelocity1, quantum);
+    key[2] = QUANTIZE(s->angularPosition2, quantum);
+    key[3] = QUANTIZE(s->angularVelocity2, quantum);
+    key[4] = s->isTerminal;
 
 }
 
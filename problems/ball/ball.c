@@ -46,6 +46,7 @@ action** actions = NULL;                        //Array of action
 
 double* parameters = NULL;                      //Model's parameters
 unsigned int nbParameters = 3;                  //Number of model's parameters
+uint64_t modelSeed = 0;                         //Seed of the random streams of the model
 
 /*+------------Model's parameters------------+
   |                                          |
@@ -151,29 +152,27 @@ state* initState() {
 }
 
 
-/* Returns a triplet containing the next state, the applied action and the reward given the current state and action. */
+/* Writes the next state in nextState and returns the reward given the current state and action. */
 
-char nextStateReward(state* s, action* a, state** nextState,double* reward) {
+char nextStateRewardInto(state* s, action* a, state* nextState, double* reward) {
 
     *reward = 0.0;
 
-    state* newState = (state*)malloc(sizeof(state));
+    nextState->position = s->position;
 
-    newState->position = s->position;
+    nextState->velocity = s->velocity;
 
-    newState->velocity = s->velocity;
+    nextState->velocity += (a->acceleration * timeStep);
 
-    newState->velocity += (a->acceleration * timeStep);
+    if(fabs(nextState->velocity) > parameters[2])
+        nextState->velocity = nextState->velocity > 0.0 ? parameters[2] : -parameters[2];
 
-    if(fabs(newState->velocity) > parameters[2])
-        newState->velocity = newState->velocity > 0.0 ? parameters[2] : -parameters[2];
+    nextState->position += (nextState->velocity * timeStep);
 
-    newState->position += (newState->velocity * timeStep);
-
-/*    if(fabs(newState->position) > parameters[0]) {
-        newState->isTerminal = -1;
+/*    if(fabs(nextState->position) > parameters[0]) {
+        nextState->isTerminal = -1;
     } else {*/
-        *reward = 1 - pow(newState->position, 2);
+        *reward = 1 - pow(nextState->position, 2);
 
         if(*reward < 0.0)
             *reward = 0.0;
@@ -181,12 +180,62 @@ char nextStateReward(state* s, action* a, state** nextState,double* reward) {
         if(*reward > 1.0)
             *reward = 1.0;
 
-        newState->isTerminal = 0;
+        nextState->isTerminal = 0;
 //    }
 
-    *nextState = newState;
+    return nextState->isTerminal;
+
+}
+
+
+/* Returns an allocated next state and the reward given the current state and action. */
+
+char nextStateReward(state* s, action* a, state** nextState, double* reward) {
+
+    *nextState = (state*)malloc(sizeof(state));
+
+    return nextStateRewardInto(s, a, *nextState, reward);
+
+}
+
+
+/* Writes the next states and the rewards of the K actions at once. */
+
+void nextStatesRewardsInto(state* s, state* nextStates, double* rewards, char* results) {
+
+    unsigned int i = 0;
+
+    for(; i < K; i++)
+        results[i] = nextStateRewardInto(s, actions[i], nextStates + i, rewards + i);
+
+}
+
+
+/* Returns the size of a state. */
+
+size_t getStateSize() {
+
+    return sizeof(state);
+
+}
+
+
+/* Returns the number of values in the key of a state. */
+
+unsigned int getStateKeyLength() {
+
+    return 3;
+
+}
+
+
+/* Writes the key of s: its variables, rounded if quantum is greater than 0, and whether it is terminal. */
+
+void getStateKey(state* s, double quantum, double* key) {
 
-    return newState->isTerminal;
+    key[0] = QUANTIZE(s->position, quantum);
+    key[1] = QUANTIZE(s->velocity, quantum);
+    key[2] = s->isTerminal;
 
 }
 
@@ -38,10 +38,9 @@
 #include <math.h>
 #undef __USE_GNU
 #include <string.h>
-#include <gsl/gsl_rng.h>
-#include <time.h>
 
 #include "boat.h"
+#include "../rng.h"
 
 unsigned int K = 2;
 action** actions = NULL;
@@ -50,6 +49,7 @@ double timeStep = 0.1;							/* Time step between two state */
 
 double* parameters = NULL;						/* Model's parameters */
 unsigned int nbParameters = 10;					/* Number of model's parameters */
+uint64_t modelSeed = 0;                         /* Seed of the random streams of the model */
 
 /*+------------Model's parameters----------+
   |                                        |
@@ -185,15 +185,18 @@ state* makeState(const char* str) {
 /* Returns an allocated initial state of the model. */
 
 state* initState() {
-    gsl_rng* rng = gsl_rng_alloc(gsl_rng_mt19937);
-    gsl_rng_set(rng, time(NULL));
+
+    static unsigned int nbInitialStates = 0;                                        /* Each initial state is drawn from a stream of its own */
+    rng_stream rng;
 
     state* init = (state*)malloc(sizeof(state));
 
+    rng_initStream(&rng, modelSeed, RNG_STREAM(RNG_MODEL, nbInitialStates++, 0));
+
     init->xPosition = 0.0;
-    init->yPosition = gsl_rng_uniform(rng) * 200;
+    init->yPosition = rng_uniform(&rng) * 200;
 
-    init->boatAngle = (gsl_rng_uniform(rng) * M_PIl) - (M_PIl/2.0);
+    init->boatAngle = (rng_uniform(&rng) * M_PIl) - (M_PIl/2.0);
     init->rudderAngle = 0.0;
 
     init->velocity = 0.0;
@@ -205,53 +208,107 @@ state* initState() {
 }
 
 
-char nextStateReward(state* s, action* a, state** nextState,double* reward) {
+char nextStateRewardInto(state* s, action* a, state* nextState, double* reward) {
 
     if(s->isTerminal) {	
-        *nextState = copyState(s);
+        memcpy(nextState, s, sizeof(state));
         *reward = s->isTerminal < 0 ? 0.0 : 1.0;
     } else {
         double quarterPI = M_PIl / 4.0;
         double distance = 0;
 
-        *nextState = (state*)malloc(sizeof(state));
-
-        (*nextState)->rudderAngle = parameters[4] * (a->desiredDirection - s->boatAngle);
-        if((*nextState)->rudderAngle < -quarterPI)
-            (*nextState)->rudderAngle = -quarterPI;
-        else if((*nextState)->rudderAngle > quarterPI)
-            (*nextState)->rudderAngle = quarterPI;
-
-        (*nextState)->velocity = s->velocity + ((parameters[3] - s->velocity) * parameters[1]);
-        (*nextState)->omega = s->omega + (((*nextState)->rudderAngle - s->omega) * ((*nextState)->velocity / parameters[2]));
-        (*nextState)->boatAngle = s->boatAngle + (parameters[1] * (*nextState)->omega);
-        (*nextState)->xPosition = s->xPosition + ((*nextState)->velocity * cos((*nextState)->boatAngle));
-        if((*nextState)->xPosition < 0)
-            (*nextState)->xPosition = 0;
-        else if((*nextState)->xPosition > 200)
-            (*nextState)->xPosition = 200;
-
-        (*nextState)->yPosition = s->yPosition - ((*nextState)->velocity * sin((*nextState)->boatAngle)) - (parameters[0] * (((*nextState)->xPosition / 50.0) - ((*nextState)->xPosition * (*nextState)->xPosition / 10000.0)));
-        if((*nextState)->yPosition < 0)
-            (*nextState)->yPosition = 0;
-        else if((*nextState)->yPosition > 200)
-            (*nextState)->yPosition = 200;
-
-        distance = sqrt(((parameters[5] - (*nextState)->xPosition) * (parameters[5] - (*nextState)->xPosition)) + ((parameters[6] - (*nextState)->yPosition) * (parameters[6] - (*nextState)->yPosition)));
-
-        if(((*nextState)->xPosition == parameters[5]) && (distance > parameters[7])) {
-            (*nextState)->isTerminal = -1;
+        nextState->rudderAngle = parameters[4] * (a->desiredDirection - s->boatAngle);
+        if(nextState->rudderAngle < -quarterPI)
+            nextState->rudderAngle = -quarterPI;
+        else if(nextState->rudderAngle > quarterPI)
+            nextState->rudderAngle = quarterPI;
+
+        nextState->velocity = s->velocity + ((parameters[3] - s->velocity) * parameters[1]);
+        nextState->omega = s->omega + ((nextState->rudderAngle - s->omega) * (nextState->velocity / parameters[2]));
+        nextState->boatAngle = s->boatAngle + (parameters[1] * nextState->omega);
+        nextState->xPosition = s->xPosition + (nextState->velocity * cos(nextState->boatAngle));
+        if(nextState->xPosition < 0)
+            nextState->xPosition = 0;
+        else if(nextState->xPosition > 200)
+            nextState->xPosition = 200;
+
+        nextState->yPosition = s->yPosition - (nextState->velocity * sin(nextState->boatAngle)) - (parameters[0] * ((nextState->xPosition / 50.0) - (nextState->xPosition * nextState->xPosition / 10000.0)));
+        if(nextState->yPosition < 0)
+            nextState->yPosition = 0;
+        else if(nextState->yPosition > 200)
+            nextState->yPosition = 200;
+
+        distance = sqrt(((parameters[5] - nextState->xPosition) * (parameters[5] - nextState->xPosition)) + ((parameters[6] - nextState->yPosition) * (parameters[6] - nextState->yPosition)));
+
+        if((nextState->xPosition == parameters[5]) && (distance > parameters[7])) {
+            nextState->isTerminal = -1;
             *reward = 0.0;
-        } else if(((*nextState)->xPosition == parameters[5]) && (distance < parameters[7])) {
-            (*nextState)->isTerminal = 1;
+        } else if((nextState->xPosition == parameters[5]) && (distance < parameters[7])) {
+            nextState->isTerminal = 1;
             *reward = 1.0;
         } else {
-            (*nextState)->isTerminal = 0;
+            nextState->isTerminal = 0;
             *reward = 1.0 - (distance / sqrt((200 * 200) + (200 * 200)));
         }
     }
 
-    return (*nextState)->isTerminal;
+    return nextState->isTerminal;
+
+}
+
+
+/* Returns an allocated next state and the reward given the current state and action. */
+
+char nextStateReward(state* s, action* a, state** nextState, double* reward) {
+
+    *nextState = (state*)malloc(sizeof(state));
+
+    return nextStateRewardInto(s, a, *nextState, reward);
+
+}
+
+
+/* Writes the next states and the rewards of the K actions at once. */
+
+void nextStatesRewardsInto(state* s, state* nextStates, double* rewards, char* results) {
+
+    unsigned int i = 0;
+
+    for(; i < K; i++)
+        results[i] = nextStateRewardInto(s, actions[i], nextStates + i, rewards + i);
+
+}
+
+
+/* Returns the size of a state. */
+
+size_t getStateSize() {
+
+    return sizeof(state);
+
+}
+
+
+/* Returns the number of values in the key of a state. */
+
+unsigned int getStateKeyLength() {
+
+    return 7;
+
+}
+
+
+/* Writes the key of s: its variables, rounded if quantum is greater than 0, and whether it is terminal. */
+
+void getStateKey(state* s, double quantum, double* key) {
+
+    key[0] = QUANTIZE(s->xPosition, quantum);
+    key[1] = QUANTIZE(s->yPosition, quantum);
+    key[2] = QUANTIZE(s->boatAngle, quantum);
+    key[3] = QUANTIZE(s->rudderAngle, quantum);
+    key[4] = QUANTIZE(s->velocity, quantum);
+    key[5] = QUANTIZE(s->omega, quantum);
+    key[6] = s->isTerminal;
 
 }
 
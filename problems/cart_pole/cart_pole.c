@@ -40,6 +40,7 @@
 #include <string.h>
 
 #include "cart_pole.h"
+#include "../simd.h"
 
 unsigned int K = 2;								//Number of actions that can be applied in a state
 double timeStep = 0.1;							//Time step between two state
@@ -48,6 +49,7 @@ action** actions = NULL;							//Array of action
 
 double* parameters = NULL;						//Model's parameters
 unsigned int nbParameters = 10;					//Number of model's parameters
+uint64_t modelSeed = 0;                         //Seed of the random streams of the model
 
 /*+---------------Model's parameters--------------+
   |                                               |
@@ -187,10 +189,10 @@ state* initState() {
 }
 
 
-char nextStateReward(state* s, action* a, state** nextState,double* reward) {
+char nextStateRewardInto(state* s, action* a, state* nextState, double* reward) {
 
     if(s->isTerminal) {	
-        *nextState = copyState(s);
+        memcpy(nextState, s, sizeof(state));
         *reward = 0.0;
     } else {
         double a11 = (4.0 * parameters[2]) / 3.0;
@@ -202,34 +204,156 @@ char nextStateReward(state* s, action* a, state** nextState,double* reward) {
         double angularAcceleration = ((b2 * a12) - (a22 * b1)) / ((a12 * a21) - (a11 * a22));
         double xAcceleration = (b1 - (a11 * angularAcceleration)) / a12;
 
-        *nextState = (state*)malloc(sizeof(state));
+        nextState->angularVelocity = s->angularVelocity + (timeStep * angularAcceleration);
+        if(fabs(nextState->angularVelocity) > parameters[9])
+            nextState->angularVelocity = nextState->angularVelocity > 0.0 ? parameters[9] : - parameters[9];
 
-        (*nextState)->angularVelocity = s->angularVelocity + (timeStep * angularAcceleration);
-        if(fabs((*nextState)->angularVelocity) > parameters[9])
-            (*nextState)->angularVelocity = (*nextState)->angularVelocity > 0.0 ? parameters[9] : - parameters[9];
+        nextState->xVelocity = s->xVelocity + (timeStep * xAcceleration);
+        if(fabs(nextState->xVelocity) > parameters[8])
+            nextState->xVelocity = nextState->xVelocity > 0.0 ? parameters[8] : - parameters[8];
 
-        (*nextState)->xVelocity = s->xVelocity + (timeStep * xAcceleration);
-        if(fabs((*nextState)->xVelocity) > parameters[8])
-            (*nextState)->xVelocity = (*nextState)->xVelocity > 0.0 ? parameters[8] : - parameters[8];
+        nextState->angularPosition = s->angularPosition + (timeStep * nextState->angularVelocity);
+        if(nextState->angularPosition > (2.0 * M_PIl))
+            nextState->angularPosition = nextState->angularPosition - (2.0 * M_PIl);
+        if(nextState->angularPosition < 0.0)
+            nextState->angularPosition = nextState->angularPosition + (2.0 * M_PIl);
 
-        (*nextState)->angularPosition = s->angularPosition + (timeStep * (*nextState)->angularVelocity);
-        if((*nextState)->angularPosition > (2.0 * M_PIl))
-            (*nextState)->angularPosition = (*nextState)->angularPosition - (2.0 * M_PIl);
-        if((*nextState)->angularPosition < 0.0)
-            (*nextState)->angularPosition = (*nextState)->angularPosition + (2.0 * M_PIl);
+        nextState->xPosition = s->xPosition + (timeStep * nextState->xVelocity);
 
-        (*nextState)->xPosition = s->xPosition + (timeStep * (*nextState)->xVelocity);
-
-        if(fabs((*nextState)->xPosition) > parameters[1]) {
-            (*nextState)->isTerminal = -1;
+        if(fabs(nextState->xPosition) > parameters[1]) {
+            nextState->isTerminal = -1;
             *reward = 0.0;
         } else {
-            (*nextState)->isTerminal = 0;
-            *reward = (1.0 + cos((*nextState)->angularPosition)) / 2.0;
+            nextState->isTerminal = 0;
+            *reward = (1.0 + cos(nextState->angularPosition)) / 2.0;
         }
     }
 
-    return (*nextState)->isTerminal;
+    return nextState->isTerminal;
+
+}
+
+
+/* Returns an allocated next state and the reward given the current state and action. */
+
+char nextStateReward(state* s, action* a, state** nextState, double* reward) {
+
+    *nextState = (state*)malloc(sizeof(state));
+
+    return nextStateRewardInto(s, a, *nextState, reward);
+
+}
+
+
+/* Writes the next states and the rewards of the K actions at once. What does not depend on the action is computed
+ * once, the rest SIMD_WIDTH actions at a time. */
+
+void nextStatesRewardsInto(state* s, state* nextStates, double* rewards, char* results) {
+
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    if(s->isTerminal) {
+        for(; i < K; i++) {
+            memcpy(nextStates + i, s, sizeof(state));
+            rewards[i] = 0.0;
+            results[i] = s->isTerminal;
+        }
+    } else {
+        double a11 = (4.0 * parameters[2]) / 3.0;
+        double a22 = -(parameters[3] + parameters[4]);
+        double a12 = -cos(s->angularPosition);
+        double a21 = parameters[2] * parameters[4] * cos(s->angularPosition);
+        double b1 = parameters[0] * sin(s->angularPosition) - ((parameters[6] * s->angularVelocity) / (parameters[2] * parameters[4]));
+        simd_double b2Term = simd_set(parameters[2] * parameters[4] * s->angularVelocity * s->angularVelocity * sin(s->angularPosition));
+        simd_double friction = simd_set(s->xVelocity == 0 ? 0: (s->xVelocity > 0.0 ? -parameters[5] : parameters[5]));
+        double a22b1 = a22 * b1;
+        double denominator = (a12 * a21) - (a11 * a22);
+        simd_double maxAngularVelocity = simd_set(parameters[9]);
+        simd_double maxXVelocity = simd_set(parameters[8]);
+
+        for(; i < K; i += SIMD_WIDTH) {
+            simd_double xAcceleration;
+            simd_double b2;
+            simd_double angularAcceleration;
+            simd_double angularVelocity;
+            simd_double xVelocity;
+            simd_double angularPosition;
+            simd_double xPosition;
+
+            for(j = 0; j < SIMD_WIDTH; j++)
+                xAcceleration[j] = actions[SIMD_ACTION(i, j)]->xAcceleration;
+
+            b2 = (b2Term - xAcceleration) + friction;
+            angularAcceleration = ((b2 * a12) - a22b1) / denominator;
+            xAcceleration = (b1 - (a11 * angularAcceleration)) / a12;
+
+            angularVelocity = s->angularVelocity + (timeStep * angularAcceleration);
+            angularVelocity = simd_select((simd_mask)(simd_fabs(angularVelocity) > maxAngularVelocity), simd_select((simd_mask)(angularVelocity > 0.0), maxAngularVelocity, -maxAngularVelocity), angularVelocity);
+
+            xVelocity = s->xVelocity + (timeStep * xAcceleration);
+            xVelocity = simd_select((simd_mask)(simd_fabs(xVelocity) > maxXVelocity), simd_select((simd_mask)(xVelocity > 0.0), maxXVelocity, -maxXVelocity), xVelocity);
+
+            angularPosition = s->angularPosition + (timeStep * angularVelocity);
+            xPosition = s->xPosition + (timeStep * xVelocity);
+
+            for(j = 0; (j < SIMD_WIDTH) && ((i + j) < K); j++) {
+                state* nextState = nextStates + i + j;
+
+                nextState->angularVelocity = angularVelocity[j];
+                nextState->xVelocity = xVelocity[j];
+
+                nextState->angularPosition = angularPosition[j];
+                if(nextState->angularPosition > (2.0 * M_PIl))
+                    nextState->angularPosition = nextState->angularPosition - (2.0 * M_PIl);
+                if(nextState->angularPosition < 0.0)
+                    nextState->angularPosition = nextState->angularPosition + (2.0 * M_PIl);
+
+                nextState->xPosition = xPosition[j];
+
+                if(fabs(nextState->xPosition) > parameters[1]) {
+                    nextState->isTerminal = -1;
+                    rewards[i + j] = 0.0;
+                } else {
+                    nextState->isTerminal = 0;
+                    rewards[i + j] = (1.0 + cos(nextState->angularPosition)) / 2.0;
+                }
+
+                results[i + j] = nextState->isTerminal;
+            }
+        }
+    }
+
+}
+
+
+/* Returns the size of a state. */
+
+size_t getStateSize() {
+
+    return sizeof(state);
+
+}
+
+
+/* Returns the number of values in the key of a state. */
+
+unsigned int getStateKeyLength() {
+
+    return 5;
+
+}
+
+
+/* Writes the key of s: its variables, rounded if quantum is greater than 0, and whether it is terminal. */
+
+void getStateKey(state* s, double quantum, double* key) {
+
+    key[0] = QUANTIZE(s->xPosition, quantum);
+    key[1] = QUANTIZE(s->xVelocity, quantum);
+    key[2] = QUANTIZE(s->angularPosition, quantum);
+    key[3] = QUANTIZE(s->angularVelocity, quantum);
+    key[4] = s->isTerminal;
 
 }
 
@@ -40,6 +40,7 @@
 #include <string.h>
 
 #include "double_cart_pole.h"
+#include "../simd.h"
 
 unsigned int K = 4;                         //Number of actions that can be applied in a state
 double timeStep = 0.1;                      //Time step between two state
@@ -48,6 +49,7 @@ action** actions = NULL;                    //Array of action
 
 double* parameters = NULL;                  //Model's parameters
 unsigned int nbParameters = 22;             //Number of model's parameters 
+uint64_t modelSeed = 0;                         //Seed of the random streams of the model
 
 
 /*+----------------------Model's parameters----------------------+
@@ -237,74 +239,245 @@ state* initState() {
 }
 
 
-char nextStateReward(state* s, action* a, state** nextState,double* reward) {
+char nextStateRewardInto(state* s, action* a, state* nextState, double* reward) {
 
-    *nextState = copyState(s);
+    memcpy(nextState, s, sizeof(state));
     *reward = 0.0;
 
-    if(!(*nextState)->isTerminal) {
+    if(!nextState->isTerminal) {
         double a11_1 = (4.0 * parameters[2]) / 3.0;
         double a22_1 = -(parameters[4] + parameters[6]);
         double a11_2 = (4.0 * parameters[3]) / 3.0;
         double a22_2 = -(parameters[5] + parameters[7]);
-        double xForce = a->xAcceleration1 - (parameters[12] * (parameters[13] - fabs((*nextState)->xPosition2 - (*nextState)->xPosition1)));
-        double a12 = -cos((*nextState)->angularPosition1);
-        double a21 = parameters[2] * parameters[6] * cos((*nextState)->angularPosition1);
-        double b1 = parameters[0] * sin((*nextState)->angularPosition1) - ((parameters[10] * (*nextState)->angularVelocity1) / (parameters[2] * parameters[6]));
-        double b2 = (parameters[2] * parameters[6] * (*nextState)->angularVelocity1 * (*nextState)->angularVelocity1 * sin((*nextState)->angularPosition1)) - xForce + ((*nextState)->xVelocity1 > 0.0 ? -parameters[8] : parameters[8]);
+        double xForce = a->xAcceleration1 - (parameters[12] * (parameters[13] - fabs(nextState->xPosition2 - nextState->xPosition1)));
+        double a12 = -cos(nextState->angularPosition1);
+        double a21 = parameters[2] * parameters[6] * cos(nextState->angularPosition1);
+        double b1 = parameters[0] * sin(nextState->angularPosition1) - ((parameters[10] * nextState->angularVelocity1) / (parameters[2] * parameters[6]));
+        double b2 = (parameters[2] * parameters[6] * nextState->angularVelocity1 * nextState->angularVelocity1 * sin(nextState->angularPosition1)) - xForce + (nextState->xVelocity1 > 0.0 ? -parameters[8] : parameters[8]);
 
         double angularAcceleration1 = ((b2 * a12) - (a22_1 * b1)) / ((a12 * a21) - (a11_1 * a22_1));
         double xAcceleration1 = (b1 - (a11_1 * angularAcceleration1)) / a12;
 
-        (*nextState)->angularVelocity1 = (*nextState)->angularVelocity1 + (timeStep * angularAcceleration1);
-        if(fabs((*nextState)->angularVelocity1) > parameters[20])
-            (*nextState)->angularVelocity1 = (*nextState)->angularVelocity1 > 0.0 ? parameters[20] : - parameters[20];
+        nextState->angularVelocity1 = nextState->angularVelocity1 + (timeStep * angularAcceleration1);
+        if(fabs(nextState->angularVelocity1) > parameters[20])
+            nextState->angularVelocity1 = nextState->angularVelocity1 > 0.0 ? parameters[20] : - parameters[20];
 
-        (*nextState)->xVelocity1 = (*nextState)->xVelocity1 + (timeStep * xAcceleration1);
-        if(fabs((*nextState)->xVelocity1) > parameters[18])
-            (*nextState)->xVelocity1 = (*nextState)->xVelocity1 > 0.0 ? parameters[18] : - parameters[18];
+        nextState->xVelocity1 = nextState->xVelocity1 + (timeStep * xAcceleration1);
+        if(fabs(nextState->xVelocity1) > parameters[18])
+            nextState->xVelocity1 = nextState->xVelocity1 > 0.0 ? parameters[18] : - parameters[18];
 
-        (*nextState)->angularPosition1 = (*nextState)->angularPosition1 + (timeStep * (*nextState)->angularVelocity1);
-        if((*nextState)->angularPosition1 > (2.0 * M_PIl))
-            (*nextState)->angularPosition1 = (*nextState)->angularPosition1 - (2.0 * M_PIl);
-        if((*nextState)->angularPosition1 < 0.0)
-            (*nextState)->angularPosition1 = (*nextState)->angularPosition1 + (2.0 * M_PIl);
+        nextState->angularPosition1 = nextState->angularPosition1 + (timeStep * nextState->angularVelocity1);
+        if(nextState->angularPosition1 > (2.0 * M_PIl))
+            nextState->angularPosition1 = nextState->angularPosition1 - (2.0 * M_PIl);
+        if(nextState->angularPosition1 < 0.0)
+            nextState->angularPosition1 = nextState->angularPosition1 + (2.0 * M_PIl);
 
-        (*nextState)->xPosition1 = (*nextState)->xPosition1 + (timeStep * (*nextState)->xVelocity1);
+        nextState->xPosition1 = nextState->xPosition1 + (timeStep * nextState->xVelocity1);
 
 
-        xForce = a->xAcceleration2 + (parameters[12] * (parameters[13] - fabs((*nextState)->xPosition2 - (*nextState)->xPosition1)));
-        a12 = -cos((*nextState)->angularPosition2);
-        a21 = parameters[3] * parameters[7] * cos((*nextState)->angularPosition2);
-        b1 = parameters[0] * sin((*nextState)->angularPosition2) - ((parameters[11] * (*nextState)->angularVelocity2) / (parameters[3] * parameters[7]));
-        b2 = (parameters[3] * parameters[7] * (*nextState)->angularVelocity2 * (*nextState)->angularVelocity2 * sin((*nextState)->angularPosition2)) - xForce + ((*nextState)->xVelocity2 > 0.0 ? -parameters[9] : parameters[9]);
+        xForce = a->xAcceleration2 + (parameters[12] * (parameters[13] - fabs(nextState->xPosition2 - nextState->xPosition1)));
+        a12 = -cos(nextState->angularPosition2);
+        a21 = parameters[3] * parameters[7] * cos(nextState->angularPosition2);
+        b1 = parameters[0] * sin(nextState->angularPosition2) - ((parameters[11] * nextState->angularVelocity2) / (parameters[3] * parameters[7]));
+        b2 = (parameters[3] * parameters[7] * nextState->angularVelocity2 * nextState->angularVelocity2 * sin(nextState->angularPosition2)) - xForce + (nextState->xVelocity2 > 0.0 ? -parameters[9] : parameters[9]);
 
         double angularAcceleration2 = ((b2 * a12) - (a22_2 * b1)) / ((a12 * a21) - (a11_2 * a22_2));
         double xAcceleration2 = (b1 - (a11_2 * angularAcceleration2)) / a12;
 
-        (*nextState)->angularVelocity2 = (*nextState)->angularVelocity2 + (timeStep * angularAcceleration2);
-        if(fabs((*nextState)->angularVelocity2) > parameters[20])
-            (*nextState)->angularVelocity2 = (*nextState)->angularVelocity2 > 0.0 ? parameters[20] : - parameters[20];
+        nextState->angularVelocity2 = nextState->angularVelocity2 + (timeStep * angularAcceleration2);
+        if(fabs(nextState->angularVelocity2) > parameters[20])
+            nextState->angularVelocity2 = nextState->angularVelocity2 > 0.0 ? parameters[20] : - parameters[20];
 
-        (*nextState)->xVelocity2 = (*nextState)->xVelocity2 + (timeStep * xAcceleration2);
-        if(fabs((*nextState)->xVelocity2) > parameters[18])
-            (*nextState)->xVelocity2 = (*nextState)->xVelocity2 > 0.0 ? parameters[18] : - parameters[18];
+        nextState->xVelocity2 = nextState->xVelocity2 + (timeStep * xAcceleration2);
+        if(fabs(nextState->xVelocity2) > parameters[18])
+            nextState->xVelocity2 = nextState->xVelocity2 > 0.0 ? parameters[18] : - parameters[18];
 
-        (*nextState)->angularPosition2 = (*nextState)->angularPosition2 + (timeStep * (*nextState)->angularVelocity2);
-        if((*nextState)->angularPosition2 > (2.0 * M_PIl))
-            (*nextState)->angularPosition2 = (*nextState)->angularPosition2 - (2.0 * M_PIl);
-        if((*nextState)->angularPosition2 < 0.0)
-            (*nextState)->angularPosition2 = (*nextState)->angularPosition2 + (2.0 * M_PIl);
+        nextState->angularPosition2 = nextState->angularPosition2 + (timeStep * nextState->angularVelocity2);
+        if(nextState->angularPosition2 > (2.0 * M_PIl))
+            nextState->angularPosition2 = nextState->angularPosition2 - (2.0 * M_PIl);
+        if(nextState->angularPosition2 < 0.0)
+            nextState->angularPosition2 = nextState->angularPosition2 + (2.0 * M_PIl);
 
-        (*nextState)->xPosition2 = (*nextState)->xPosition2 + (timeStep * (*nextState)->xVelocity2);
+        nextState->xPosition2 = nextState->xPosition2 + (timeStep * nextState->xVelocity2);
 
-        if((fabs((*nextState)->xPosition1) >= parameters[1]) || (fabs((*nextState)->xPosition2) >= parameters[1]) || ((*nextState)->xPosition2 <= (*nextState)->xPosition1) || (fabs((*nextState)->xPosition2 - (*nextState)->xPosition1) < parameters[14]) || (fabs((*nextState)->xPosition2 - (*nextState)->xPosition1) > parameters[15]))
-            (*nextState)->isTerminal = -1;
+        if((fabs(nextState->xPosition1) >= parameters[1]) || (fabs(nextState->xPosition2) >= parameters[1]) || (nextState->xPosition2 <= nextState->xPosition1) || (fabs(nextState->xPosition2 - nextState->xPosition1) < parameters[14]) || (fabs(nextState->xPosition2 - nextState->xPosition1) > parameters[15]))
+            nextState->isTerminal = -1;
         else
-            *reward = ((1.0 + cos((*nextState)->angularPosition1)) / 4.0) + ((1.0 + cos((*nextState)->angularPosition2)) / 4.0);
+            *reward = ((1.0 + cos(nextState->angularPosition1)) / 4.0) + ((1.0 + cos(nextState->angularPosition2)) / 4.0);
+    }
+
+    return nextState->isTerminal;
+
+}
+
+
+/* Returns an allocated next state and the reward given the current state and action. */
+
+char nextStateReward(state* s, action* a, state** nextState, double* reward) {
+
+    *nextState = (state*)malloc(sizeof(state));
+
+    return nextStateRewardInto(s, a, *nextState, reward);
+
+}
+
+
+/* Writes the next states and the rewards of the K actions at once. What does not depend on the action is computed
+ * once, the rest SIMD_WIDTH actions at a time. */
+
+void nextStatesRewardsInto(state* s, state* nextStates, double* rewards, char* results) {
+
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    if(s->isTerminal) {
+        for(; i < K; i++) {
+            memcpy(nextStates + i, s, sizeof(state));
+            rewards[i] = 0.0;
+            results[i] = s->isTerminal;
+        }
+    } else {
+        double a11_1 = (4.0 * parameters[2]) / 3.0;
+        double a22_1 = -(parameters[4] + parameters[6]);
+        double a11_2 = (4.0 * parameters[3]) / 3.0;
+        double a22_2 = -(parameters[5] + parameters[7]);
+        double spring1 = parameters[12] * (parameters[13] - fabs(s->xPosition2 - s->xPosition1));
+
+        double a12_1 = -cos(s->angularPosition1);
+        double a21_1 = parameters[2] * parameters[6] * cos(s->angularPosition1);
+        double b1_1 = parameters[0] * sin(s->angularPosition1) - ((parameters[10] * s->angularVelocity1) / (parameters[2] * parameters[6]));
+        simd_double b2Term1 = simd_set(parameters[2] * parameters[6] * s->angularVelocity1 * s->angularVelocity1 * sin(s->angularPosition1));
+        double friction1 = s->xVelocity1 > 0.0 ? -parameters[8] : parameters[8];
+        double a22b1_1 = a22_1 * b1_1;
+        double denominator1 = (a12_1 * a21_1) - (a11_1 * a22_1);
+
+        double a12_2 = -cos(s->angularPosition2);
+        double a21_2 = parameters[3] * parameters[7] * cos(s->angularPosition2);
+        double b1_2 = parameters[0] * sin(s->angularPosition2) - ((parameters[11] * s->angularVelocity2) / (parameters[3] * parameters[7]));
+        simd_double b2Term2 = simd_set(parameters[3] * parameters[7] * s->angularVelocity2 * s->angularVelocity2 * sin(s->angularPosition2));
+        double friction2 = s->xVelocity2 > 0.0 ? -parameters[9] : parameters[9];
+        double a22b1_2 = a22_2 * b1_2;
+        double denominator2 = (a12_2 * a21_2) - (a11_2 * a22_2);
+
+        simd_double maxAngularVelocity = simd_set(parameters[20]);
+        simd_double maxXVelocity = simd_set(parameters[18]);
+
+        for(; i < K; i += SIMD_WIDTH) {
+            simd_double xForce;
+            simd_double b2;
+            simd_double angularAcceleration;
+            simd_double xAcceleration;
+            simd_double angularVelocity1;
+            simd_double xVelocity1;
+            simd_double angularPosition1;
+            simd_double xPosition1;
+            simd_double angularVelocity2;
+            simd_double xVelocity2;
+            simd_double angularPosition2;
+            simd_double xPosition2;
+
+            for(j = 0; j < SIMD_WIDTH; j++)
+                xForce[j] = actions[SIMD_ACTION(i, j)]->xAcceleration1;
+
+            xForce = xForce - spring1;
+            b2 = (b2Term1 - xForce) + friction1;
+            angularAcceleration = ((b2 * a12_1) - a22b1_1) / denominator1;
+            xAcceleration = (b1_1 - (a11_1 * angularAcceleration)) / a12_1;
+
+            angularVelocity1 = s->angularVelocity1 + (timeStep * angularAcceleration);
+            angularVelocity1 = simd_select((simd_mask)(simd_fabs(angularVelocity1) > maxAngularVelocity), simd_select((simd_mask)(angularVelocity1 > 0.0), maxAngularVelocity, -maxAngularVelocity), angularVelocity1);
+
+            xVelocity1 = s->xVelocity1 + (timeStep * xAcceleration);
+            xVelocity1 = simd_select((simd_mask)(simd_fabs(xVelocity1) > maxXVelocity), simd_select((simd_mask)(xVelocity1 > 0.0), maxXVelocity, -maxXVelocity), xVelocity1);
+
+            angularPosition1 = s->angularPosition1 + (timeStep * angularVelocity1);
+            xPosition1 = s->xPosition1 + (timeStep * xVelocity1);
+
+            for(j = 0; j < SIMD_WIDTH; j++)
+                xForce[j] = actions[SIMD_ACTION(i, j)]->xAcceleration2;
+
+            xForce = xForce + (parameters[12] * (parameters[13] - simd_fabs(s->xPosition2 - xPosition1)));     // The spring sees the first cart where it has moved
+            b2 = (b2Term2 - xForce) + friction2;
+            angularAcceleration = ((b2 * a12_2) - a22b1_2) / denominator2;
+            xAcceleration = (b1_2 - (a11_2 * angularAcceleration)) / a12_2;
+
+            angularVelocity2 = s->angularVelocity2 + (timeStep * angularAcceleration);
+            angularVelocity2 = simd_select((simd_mask)(simd_fabs(angularVelocity2) > maxAngularVelocity), simd_select((simd_mask)(angularVelocity2 > 0.0), maxAngularVelocity, -maxAngularVelocity), angularVelocity2);
+
+            xVelocity2 = s->xVelocity2 + (timeStep * xAcceleration);
+            xVelocity2 = simd_select((simd_mask)(simd_fabs(xVelocity2) > maxXVelocity), simd_select((simd_mask)(xVelocity2 > 0.0), maxXVelocity, -maxXVelocity), xVelocity2);
+
+            angularPosition2 = s->angularPosition2 + (timeStep * angularVelocity2);
+            xPosition2 = s->xPosition2 + (timeStep * xVelocity2);
+
+            for(j = 0; (j < SIMD_WIDTH) && ((i + j) < K); j++) {
+                state* nextState = nextStates + i + j;
+
+                nextState->angularVelocity1 = angularVelocity1[j];
+                nextState->xVelocity1 = xVelocity1[j];
+                nextState->angularPosition1 = angularPosition1[j];
+                if(nextState->angularPosition1 > (2.0 * M_PIl))
+                    nextState->angularPosition1 = nextState->angularPosition1 - (2.0 * M_PIl);
+                if(nextState->angularPosition1 < 0.0)
+                    nextState->angularPosition1 = nextState->angularPosition1 + (2.0 * M_PIl);
+                nextState->xPosition1 = xPosition1[j];
+
+                nextState->angularVelocity2 = angularVelocity2[j];
+                nextState->xVelocity2 = xVelocity2[j];
+                nextState->angularPosition2 = angularPosition2[j];
+                if(nextState->angularPosition2 > (2.0 * M_PIl))
+                    nextState->angularPosition2 = nextState->angularPosition2 - (2.0 * M_PIl);
+                if(nextState->angularPosition2 < 0.0)
+                    nextState->angularPosition2 = nextState->angularPosition2 + (2.0 * M_PIl);
+                nextState->xPosition2 = xPosition2[j];
+
+                nextState->isTerminal = s->isTerminal;
+                rewards[i + j] = 0.0;
+
+                if((fabs(nextState->xPosition1) >= parameters[1]) || (fabs(nextState->xPosition2) >= parameters[1]) || (nextState->xPosition2 <= nextState->xPosition1) || (fabs(nextState->xPosition2 - nextState->xPosition1) < parameters[14]) || (fabs(nextState->xPosition2 - nextState->xPosition1) > parameters[15]))
+                    nextState->isTerminal = -1;
+                else
+                    rewards[i + j] = ((1.0 + cos(nextState->angularPosition1)) / 4.0) + ((1.0 + cos(nextState->angularPosition2)) / 4.0);
+
+                results[i + j] = nextState->isTerminal;
+            }
+        }
     }
 
-    return (*nextState)->isTerminal;
+}
+
+
+/* Returns the size of a state. */
+
+size_t getStateSize() {
+
+    return sizeof(state);
+
+}
+
+
+/* Returns the number of values in the key of a state. */
+
+unsigned int getStateKeyLength() {
+
+    return 9;
+
+}
+
+
+/* Writes the key of s: its variables, rounded if quantum is greater than 0, and whether it is terminal. */
+
+void getStateKey(state* s, double quantum, double* key) {
+
+    key[0] = QUANTIZE(s->xPosition1, quantum);
+    key[1] = QUANTIZE(s->xVelocity1, quantum);
+    key[2] = QUANTIZE(s->angularPosition1, quantum);
+    key[3] = QUANTIZE(s->angularVelocity1, quantum);
+    key[4] = QUANTIZE(s->xPosition2, quantum);
+    key[5] = QUANTIZE(s->xVelocity2, quantum);
+    key[6] = QUANTIZE(s->angularPosition2, quantum);
+    key[7] = QUANTIZE(s->angularVelocity2, quantum);
+    key[8] = s->isTerminal;
 
 }
 
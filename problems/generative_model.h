@@ -35,6 +35,9 @@
 #ifndef GENERATIVE_MODEL_H
 #define GENERATIVE_MODEL_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 /* Represent a state of the model */
 typedef struct state state;
 
@@ -50,6 +53,8 @@ extern action** actions;                            //Array of action
 extern double* parameters;							//Model's parameters
 extern unsigned int nbParameters;					//Number of model's parameters 
 
+extern uint64_t modelSeed;                          //Seed of the random streams of the model. To set before the parameters initialisation
+
 /* Initialisation of the parameters. To call before anything else.*/
 void initGenerativeModelParameters();
 
@@ -71,6 +76,24 @@ state* makeState(const char* str);
 /* Returns the state and the reward given the current state and action. */
 char nextStateReward(state* s, action* a, state** nextState, double* reward);
 
+/* Same as nextStateReward but writes the next state in nextState, storage of getStateSize() bytes owned by the caller. nextState must not be s. */
+char nextStateRewardInto(state* s, action* a, state* nextState, double* reward);
+
+/* Applies each of the K actions to s at once. The next states are written in nextStates, storage of K * getStateSize() bytes owned by the caller, in the order of the actions. What nextStateReward would return for each of them is written in rewards and results. */
+void nextStatesRewardsInto(state* s, state* nextStates, double* rewards, char* results);
+
+/* Returns the size of a state. A state holds no pointer to memory of its own so it can be copied with memcpy. */
+size_t getStateSize();
+
+/* Index of the multiple of quantum closest to x, or x itself if quantum is not greater than 0. Adding 0.0 turns -0.0 into 0.0 so that a key is the same bytes whatever the side x is rounded from. */
+#define QUANTIZE(x, quantum) (((quantum) > 0.0 ? round((x) / (quantum)) : (x)) + 0.0)
+
+/* Returns the number of values in the key of a state. */
+unsigned int getStateKeyLength();
+
+/* Writes in key, storage of getStateKeyLength() doubles owned by the caller, what tells s apart from the other states. The padding of a state is left out so that two states are the same if and only if their keys have the same bytes. If quantum is greater than 0, the continuous variables are quantized by it so that close states share a key. */
+void getStateKey(state* s, double quantum, double* key);
+
 /* Returns the id corresponding to the place of the action a in the array of action. */
 unsigned int getActionId(action* a);
 
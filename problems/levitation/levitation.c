@@ -38,10 +38,10 @@
 #include <math.h>
 #undef __USE_GNU
 #include <string.h>
-#include <gsl/gsl_rng.h>
-#include <time.h>
 
 #include "levitation.h"
+#include "../rng.h"
+#include "../simd.h"
 
 unsigned int K = 2;
 action** actions = NULL;
@@ -50,6 +50,7 @@ double timeStep = 0.004;                        /* Time step between two state *
 
 double* parameters = NULL;                      /* Model's parameters */
 unsigned int nbParameters = 11;                 /* Number of model's parameters */
+uint64_t modelSeed = 0;                         /* Seed of the random streams of the model */
 
 /*+-----------Model's parameters----------+
   |                                       |
@@ -72,8 +73,9 @@ unsigned int nbParameters = 11;                 /* Number of model's parameters
 
 void initGenerativeModelParameters() {
 
-    gsl_rng* rng = gsl_rng_alloc(gsl_rng_mt19937);
-    gsl_rng_set(rng, time(NULL));
+    rng_stream rng;
+
+    rng_initStream(&rng, modelSeed, RNG_STREAM(RNG_MODEL, 0, 0));
     parameters = (double*)malloc(sizeof(double) * nbParameters);
 
     parameters[0] = 0.8;
@@ -96,7 +98,7 @@ void initGenerativeModelParameters() {
 
     parameters[9] = 0.013;
 
-    parameters[10] = (gsl_rng_uniform(rng) * (parameters[9] - parameters[8])) + parameters[8];
+    parameters[10] = (rng_uniform(&rng) * (parameters[9] - parameters[8])) + parameters[8];
 
 }
 
@@ -265,17 +267,172 @@ void RK4OneStep(state* sIn, state* sOut, double h, double u) {
 }
 
 
-char nextStateReward(state* s, action* a, state** nextState,double* reward) {
+char nextStateRewardInto(state* s, action* a, state* nextState, double* reward) {
+
+    RK4OneStep(s, nextState, timeStep / 3.0, a->appliedCurrent);
+    RK4OneStep(nextState, nextState, timeStep / 3.0, a->appliedCurrent);
+    RK4OneStep(nextState, nextState, timeStep / 3.0, a->appliedCurrent);
+
+    *reward = 1.0 - (fabs(nextState->position - parameters[10]) / (parameters[9] - parameters[8]));
+
+    return 0;
+
+}
+
+
+/* Returns an allocated next state and the reward given the current state and action. */
+
+char nextStateReward(state* s, action* a, state** nextState, double* reward) {
 
     *nextState = (state*)malloc(sizeof(state));
 
-    RK4OneStep(s, *nextState, timeStep / 3.0, a->appliedCurrent);
-    RK4OneStep(*nextState, *nextState, timeStep / 3.0, a->appliedCurrent);
-    RK4OneStep(*nextState, *nextState, timeStep / 3.0, a->appliedCurrent);
+    return nextStateRewardInto(s, a, *nextState, reward);
 
-    *reward = 1.0 - (fabs((*nextState)->position - parameters[10]) / (parameters[9] - parameters[8]));
+}
 
-    return 0;
+
+/* The state of SIMD_WIDTH simulations, one per lane. */
+typedef struct {
+    simd_double position;
+    simd_double velocity;
+    simd_double current;
+} lanes;
+
+
+static simd_double alphaLanes(lanes* s) {
+
+    return parameters[7] - (parameters[4] * s->current * s->current / (2.0 * parameters[0] * (parameters[2] + s->position) * (parameters[2] + s->position)));
+
+}
+
+
+static simd_double betaLanes(lanes* s) {
+
+    return s->current * ((parameters[4] * s->velocity) - (parameters[1] * (parameters[2] + s->position) * (parameters[2] + s->position))) / ((parameters[4] * (parameters[2] + s->position)) + (parameters[3] * (parameters[2] + s->position) * (parameters[2] + s->position)));
+
+}
+
+
+static simd_double gammaLanes(lanes* s) {
+
+    return (parameters[2] + s->position) / (parameters[4] + (parameters[3] * (parameters[2] + s->position)));
+
+}
+
+
+/* RK4OneStep on SIMD_WIDTH simulations at once. */
+static void RK4OneStepLanes(lanes* sIn, lanes* sOut, double h, simd_double u) {
+
+    lanes tmp;
+    lanes k1;
+    lanes k2;
+    lanes k3;
+    lanes k4;
+    simd_mask isAbove;
+    simd_mask isBelow;
+
+    k1.position = sIn->velocity;
+    k1.velocity = alphaLanes(sIn);
+    k1.current = betaLanes(sIn) + (gammaLanes(sIn) * u);
+
+    tmp.position = sIn->position + (k1.position * (h / 2.0));
+    tmp.velocity = sIn->velocity + (k1.velocity * (h / 2.0));
+    tmp.current = sIn->current + (k1.current * (h / 2.0));
+
+    k2.position = tmp.velocity;
+    k2.velocity = alphaLanes(&tmp);
+    k2.current = betaLanes(&tmp) + (gammaLanes(&tmp) * u);
+
+    tmp.position = sIn->position + (k2.position * (h / 2.0));
+    tmp.velocity = sIn->velocity + (k2.velocity * (h / 2.0));
+    tmp.current = sIn->current + (k2.current * (h / 2.0));
+
+    k3.position = tmp.velocity;
+    k3.velocity = alphaLanes(&tmp);
+    k3.current = betaLanes(&tmp) + (gammaLanes(&tmp) * u);
+
+    tmp.position = sIn->position + (k3.position * h);
+    tmp.velocity = sIn->velocity + (k3.velocity * h);
+    tmp.current = sIn->current + (k3.current * h);
+
+    k4.position = tmp.velocity;
+    k4.velocity = alphaLanes(&tmp);
+    k4.current = betaLanes(&tmp) + (gammaLanes(&tmp) * u);
+
+    sOut->position = sIn->position + (h * (k1.position + (2.0 * k2.position) + (2.0 * k3.position) + k4.position) / 6.0);
+    sOut->velocity = sIn->velocity + (h * (k1.velocity + (2.0 * k2.velocity) + (2.0 * k3.velocity) + k4.velocity) / 6.0);
+    sOut->current = sIn->current + (h * (k1.current + (2.0 * k2.current) + (2.0 * k3.current) + k4.current) / 6.0);
+
+    isAbove = (simd_mask)(sOut->position > parameters[9]);
+    isBelow = (simd_mask)(sOut->position < parameters[8]);
+    sOut->position = simd_select(isAbove, simd_set(parameters[9]), simd_select(isBelow, simd_set(parameters[8]), sOut->position));
+    sOut->velocity = simd_select(isAbove | isBelow, simd_set(0.0), sOut->velocity);
+
+}
+
+
+/* Writes the next states and the rewards of the K actions at once, SIMD_WIDTH actions at a time. */
+
+void nextStatesRewardsInto(state* s, state* nextStates, double* rewards, char* results) {
+
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    for(; i < K; i += SIMD_WIDTH) {
+        simd_double appliedCurrent;
+        simd_double reward;
+        lanes next;
+
+        next.position = simd_set(s->position);
+        next.velocity = simd_set(s->velocity);
+        next.current = simd_set(s->current);
+
+        for(j = 0; j < SIMD_WIDTH; j++)
+            appliedCurrent[j] = actions[SIMD_ACTION(i, j)]->appliedCurrent;
+
+        RK4OneStepLanes(&next, &next, timeStep / 3.0, appliedCurrent);
+        RK4OneStepLanes(&next, &next, timeStep / 3.0, appliedCurrent);
+        RK4OneStepLanes(&next, &next, timeStep / 3.0, appliedCurrent);
+
+        reward = 1.0 - (simd_fabs(next.position - parameters[10]) / (parameters[9] - parameters[8]));
+
+        for(j = 0; (j < SIMD_WIDTH) && ((i + j) < K); j++) {
+            nextStates[i + j].position = next.position[j];
+            nextStates[i + j].velocity = next.velocity[j];
+            nextStates[i + j].current = next.current[j];
+            rewards[i + j] = reward[j];
+            results[i + j] = 0;
+        }
+    }
+
+}
+
+
+/* Returns the size of a state. */
+
+size_t getStateSize() {
+
+    return sizeof(state);
+
+}
+
+
+/* Returns the number of values in the key of a state. */
+
+unsigned int getStateKeyLength() {
+
+    return 3;
+
+}
+
+
+/* Writes the key of s: its variables, rounded if quantum is greater than 0. */
+
+void getStateKey(state* s, double quantum, double* key) {
+
+    key[0] = QUANTIZE(s->position, quantum);
+    key[1] = QUANTIZE(s->velocity, quantum);
+    key[2] = QUANTIZE(s->current, quantum);
 
 }
 
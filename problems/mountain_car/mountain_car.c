@@ -40,6 +40,7 @@
 #include <string.h>
 
 #include "mountain_car.h"
+#include "../simd.h"
 
 unsigned int K = 2;
 
@@ -49,6 +50,7 @@ action** actions = NULL;
 
 double* parameters = NULL;                            /*Model's parameters*/
 unsigned int nbParameters = 4;                        /*Number of model's parameters */
+uint64_t modelSeed = 0;                         /* Seed of the random streams of the model */
 
 /*+--------Model's parameters-------+
   |                                 |
@@ -157,10 +159,10 @@ state* initState() {
 }
 
 
-/* Returns a triplet containing the next state, the applied action and the reward given the current state and action. */
+/* Writes the next state in nextState and returns the reward given the current state and action. */
 
-char nextStateReward(state* s, action* a, state** nextState, double* reward) {
-    *nextState = copyState(s);
+char nextStateRewardInto(state* s, action* a, state* nextState, double* reward) {
+    memcpy(nextState, s, sizeof(state));
 
     if(s->isTerminal < 0) {
         *reward = 0.0;
@@ -169,37 +171,147 @@ char nextStateReward(state* s, action* a, state** nextState, double* reward) {
     } else {
         unsigned int i = 0;
         for(; i < 100; i++) {
-            double deltaPosition = 0.001 * (*nextState)->xVelocity;
+            double deltaPosition = 0.001 * nextState->xVelocity;
 
-            double xSquare = (*nextState)->xPosition * (*nextState)->xPosition;
-            double hillPrime = (*nextState)->xPosition < 0.0 ? (2.0 * (*nextState)->xPosition) + 1.0 : sqrt(1.0 + (5.0 * xSquare)) / ((25.0 * xSquare * xSquare) + (10.0 * xSquare) + 1.0);
-            double hillPrimePrime = (*nextState)->xPosition < 0.0 ? 2.0 : -(15.0 * (*nextState)->xPosition * sqrt(1.0 + (5.0 * xSquare)) / ((125.0 * xSquare * xSquare * xSquare) + (75.0 * xSquare * xSquare) + (15.0 * xSquare) + 1));
+            double xSquare = nextState->xPosition * nextState->xPosition;
+            double hillPrime = nextState->xPosition < 0.0 ? (2.0 * nextState->xPosition) + 1.0 : sqrt(1.0 + (5.0 * xSquare)) / ((25.0 * xSquare * xSquare) + (10.0 * xSquare) + 1.0);
+            double hillPrimePrime = nextState->xPosition < 0.0 ? 2.0 : -(15.0 * nextState->xPosition * sqrt(1.0 + (5.0 * xSquare)) / ((125.0 * xSquare * xSquare * xSquare) + (75.0 * xSquare * xSquare) + (15.0 * xSquare) + 1));
             double hillPrimeSquare = 1 + (hillPrime * hillPrime);
 
-            double deltaVelocity = 0.001 * ((a->xAcceleration / (parameters[1] * hillPrimeSquare)) - (parameters[0] * hillPrime / hillPrimeSquare) - ((*nextState)->xVelocity * (*nextState)->xVelocity * hillPrime * hillPrimePrime / hillPrimeSquare));
+            double deltaVelocity = 0.001 * ((a->xAcceleration / (parameters[1] * hillPrimeSquare)) - (parameters[0] * hillPrime / hillPrimeSquare) - (nextState->xVelocity * nextState->xVelocity * hillPrime * hillPrimePrime / hillPrimeSquare));
 
-            (*nextState)->xPosition += deltaPosition;
-            (*nextState)->xVelocity += deltaVelocity;
+            nextState->xPosition += deltaPosition;
+            nextState->xVelocity += deltaVelocity;
         }
 
-        if(fabs((*nextState)->xVelocity) > parameters[2])
-            (*nextState)->isTerminal = -1;
+        if(fabs(nextState->xVelocity) > parameters[2])
+            nextState->isTerminal = -1;
         else {
-            if((*nextState)->xPosition >= 1.0)
-                (*nextState)->isTerminal = 1;
-            if((*nextState)->xPosition < -1.0)
-                (*nextState)->isTerminal = -1;
+            if(nextState->xPosition >= 1.0)
+                nextState->isTerminal = 1;
+            if(nextState->xPosition < -1.0)
+                nextState->isTerminal = -1;
         }
 
-        if((*nextState)->isTerminal < 0)
+        if(nextState->isTerminal < 0)
             *reward = 0.0;
-        else if((*nextState)->isTerminal > 0)
+        else if(nextState->isTerminal > 0)
             *reward = 1.0;
         else
-            *reward = ((*nextState)->xPosition + 1) / 2.0;
+            *reward = (nextState->xPosition + 1) / 2.0;
     }
 
-    return (*nextState)->isTerminal;
+    return nextState->isTerminal;
+
+}
+
+
+/* Returns an allocated next state and the reward given the current state and action. */
+
+char nextStateReward(state* s, action* a, state** nextState, double* reward) {
+
+    *nextState = (state*)malloc(sizeof(state));
+
+    return nextStateRewardInto(s, a, *nextState, reward);
+
+}
+
+
+/* Writes the next states and the rewards of the K actions at once, SIMD_WIDTH actions at a time. */
+
+void nextStatesRewardsInto(state* s, state* nextStates, double* rewards, char* results) {
+
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    if(s->isTerminal) {
+        for(; i < K; i++) {
+            memcpy(nextStates + i, s, sizeof(state));
+            rewards[i] = s->isTerminal < 0 ? 0.0 : 1.0;
+            results[i] = s->isTerminal;
+        }
+    } else {
+        for(; i < K; i += SIMD_WIDTH) {
+            simd_double xAcceleration;
+            simd_double xPosition = simd_set(s->xPosition);
+            simd_double xVelocity = simd_set(s->xVelocity);
+            unsigned int k = 0;
+
+            for(j = 0; j < SIMD_WIDTH; j++)
+                xAcceleration[j] = actions[SIMD_ACTION(i, j)]->xAcceleration;
+
+            for(; k < 100; k++) {
+                simd_double deltaPosition = 0.001 * xVelocity;
+
+                simd_double xSquare = xPosition * xPosition;
+                simd_double root = simd_sqrt(1.0 + (5.0 * xSquare));
+                simd_mask isLeft = (simd_mask)(xPosition < 0.0);                            // Both sides of the hill are computed, each lane keeps its own
+                simd_double hillPrime = simd_select(isLeft, (2.0 * xPosition) + 1.0, root / ((25.0 * xSquare * xSquare) + (10.0 * xSquare) + 1.0));
+                simd_double hillPrimePrime = simd_select(isLeft, simd_set(2.0), -(15.0 * xPosition * root / ((125.0 * xSquare * xSquare * xSquare) + (75.0 * xSquare * xSquare) + (15.0 * xSquare) + 1.0)));
+                simd_double hillPrimeSquare = 1.0 + (hillPrime * hillPrime);
+
+                simd_double deltaVelocity = 0.001 * ((xAcceleration / (parameters[1] * hillPrimeSquare)) - (parameters[0] * hillPrime / hillPrimeSquare) - (xVelocity * xVelocity * hillPrime * hillPrimePrime / hillPrimeSquare));
+
+                xPosition += deltaPosition;
+                xVelocity += deltaVelocity;
+            }
+
+            for(j = 0; (j < SIMD_WIDTH) && ((i + j) < K); j++) {
+                state* nextState = nextStates + i + j;
+
+                nextState->xPosition = xPosition[j];
+                nextState->xVelocity = xVelocity[j];
+                nextState->isTerminal = 0;
+
+                if(fabs(nextState->xVelocity) > parameters[2])
+                    nextState->isTerminal = -1;
+                else {
+                    if(nextState->xPosition >= 1.0)
+                        nextState->isTerminal = 1;
+                    if(nextState->xPosition < -1.0)
+                        nextState->isTerminal = -1;
+                }
+
+                if(nextState->isTerminal < 0)
+                    rewards[i + j] = 0.0;
+                else if(nextState->isTerminal > 0)
+                    rewards[i + j] = 1.0;
+                else
+                    rewards[i + j] = (nextState->xPosition + 1) / 2.0;
+
+                results[i + j] = nextState->isTerminal;
+            }
+        }
+    }
+
+}
+
+
+/* Returns the size of a state. */
+
+size_t getStateSize() {
+
+    return sizeof(state);
+
+}
+
+
+/* Returns the number of values in the key of a state. */
+
+unsigned int getStateKeyLength() {
+
+    return 3;
+
+}
+
+
+/* Writes the key of s: its variables, rounded if quantum is greater than 0, and whether it is terminal. */
+
+void getStateKey(state* s, double quantum, double* key) {
+
+    key[0] = QUANTIZE(s->xPosition, quantum);
+    key[1] = QUANTIZE(s->xVelocity, quantum);
+    key[2] = s->isTerminal;
 
 }
 
@@ -11,5 +11,5 @@ all: $(addsuffix .o,$(addprefix $(OBJ_DIR)/,$(PROBLEMS))$(if $(USE_SDL), $(addpr
 $(OBJ_DIR)/viewer_%.o: $$*/viewer_$$*.c viewer.h
 	$(CC) -c $(FLAGS) $< -o $@
 
-$(OBJ_DIR)/%.o: $$*/$$*.c $$*/$$*.h generative_model.h
+$(OBJ_DIR)/%.o: $$*/$$*.c $$*/$$*.h generative_model.h simd.h rng.h
 	$(CC) -c $(FLAGS) $< -o $@
@@ -0,0 +1,143 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/* Streams of random numbers from a Philox4x32-10 counter-based generator: the i-th block of 128 bits of a stream is
+ * the encryption of the counter (i, stream id) with the seed as key. Nothing is carried from one draw to the next but
+ * the counter, so that the streams drawn from one seed with different ids are independent and any of them can be
+ * made again from its seed and id alone, whatever the thread or the order they are used in. */
+
+/* Ids of the streams drawn from one seed. Each user of random numbers has its own range of ids, split by episode and
+ * by thread. */
+#define RNG_STREAM(user, episode, thread) (((uint64_t)(user) << 56) | (((uint64_t)(episode) & 0xffffffffffULL) << 16) | ((uint64_t)(thread) & 0xffff))
+#define RNG_MODEL 1                                 // The parameters and the initial states of a generative model
+#define RNG_RANDOM_SEARCH 2                         // The actions drawn by the random search
+#define RNG_TOOLS 3                                 // What the tools draw for themselves
+
+typedef struct {
+        uint32_t key[2];                            // The seed
+        uint32_t counter[4];                        // The index of the next block in the first two words, the id of the stream in the last two
+        uint32_t block[4];                          // The current block of random bits
+        unsigned int nbUsedWords;                   // Words of the current block already drawn
+}   rng_stream;
+
+
+static inline void rng_initStream(rng_stream* r, uint64_t seed, uint64_t streamId) {
+
+    r->key[0] = (uint32_t)seed;
+    r->key[1] = (uint32_t)(seed >> 32);
+    r->counter[0] = 0;
+    r->counter[1] = 0;
+    r->counter[2] = (uint32_t)streamId;
+    r->counter[3] = (uint32_t)(streamId >> 32);
+    r->nbUsedWords = 4;
+
+}
+
+
+/* Encrypts the counter into the block, then moves the counter to the next block. */
+static inline void rng_nextBlock(rng_stream* r) {
+
+    uint32_t c0 = r->counter[0], c1 = r->counter[1], c2 = r->counter[2], c3 = r->counter[3];
+    uint32_t k0 = r->key[0], k1 = r->key[1];
+    unsigned int i = 0;
+
+    for(; i < 10; i++) {
+        uint64_t p0 = (uint64_t)0xD2511F53 * c0;
+        uint64_t p1 = (uint64_t)0xCD9E8D57 * c2;
+
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t)p1;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t)p0;
+
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+
+    r->block[0] = c0;
+    r->block[1] = c1;
+    r->block[2] = c2;
+    r->block[3] = c3;
+    r->nbUsedWords = 0;
+
+    if(++r->counter[0] == 0)
+        r->counter[1]++;
+
+}
+
+
+static inline uint32_t rng_uint32(rng_stream* r) {
+
+    if(r->nbUsedWords == 4)
+        rng_nextBlock(r);
+
+    return r->block[r->nbUsedWords++];
+
+}
+
+
+/* Uniform in [0, 1), with the 53 bits of a double. */
+static inline double rng_uniform(rng_stream* r) {
+
+    uint64_t high = rng_uint32(r) >> 5;
+    uint64_t low = rng_uint32(r) >> 6;
+
+    return (double)((high << 26) | low) * (1.0 / 9007199254740992.0);
+
+}
+
+
+/* Uniform in {0, ..., n - 1} without bias: the draws falling in the last incomplete multiple of n are drawn again. */
+static inline unsigned int rng_uniformInt(rng_stream* r, unsigned int n) {
+
+    uint64_t m = (uint64_t)rng_uint32(r) * n;
+
+    if((uint32_t)m < n) {
+        uint32_t threshold = (uint32_t)(-n) % n;
+
+        while((uint32_t)m < threshold)
+            m = (uint64_t)rng_uint32(r) * n;
+    }
+
+    return (unsigned int)(m >> 32);
+
+}
+
+#endif
@@ -0,0 +1,96 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stdint.h>
+#include <math.h>
+
+/* Vectors of doubles for the batched simulations, one lane per action. Written with GCC vector extensions, they are
+ * SSE2 registers by default and AVX ones if the compiler is allowed to use it. */
+
+#ifdef __AVX__
+    #define SIMD_WIDTH 4
+#else
+    #define SIMD_WIDTH 2
+#endif
+
+typedef double simd_double __attribute__((vector_size(SIMD_WIDTH * sizeof(double))));
+typedef int64_t simd_mask __attribute__((vector_size(SIMD_WIDTH * sizeof(double))));     // -1 in the lanes where a comparison holds, 0 elsewhere
+
+/* Index of the action in the lane j of the vector starting at action i. Lanes past the last action repeat it. */
+#define SIMD_ACTION(i, j) (((i) + (j)) < K ? ((i) + (j)) : (K - 1))
+
+static inline simd_double simd_set(double x) {
+
+    simd_double v;
+    unsigned int j = 0;
+
+    for(; j < SIMD_WIDTH; j++)
+        v[j] = x;
+
+    return v;
+
+}
+
+
+/* Lanes of a where m holds, of b elsewhere. */
+static inline simd_double simd_select(simd_mask m, simd_double a, simd_double b) {
+
+    return (simd_double)((m & (simd_mask)a) | (~m & (simd_mask)b));
+
+}
+
+
+static inline simd_double simd_fabs(simd_double x) {
+
+    return (simd_double)((simd_mask)x & ~(simd_mask)simd_set(-0.0));
+
+}
+
+
+/* Computed lane by lane with the libm function, as the scalar code would. */
+static inline simd_double simd_sqrt(simd_double x) {
+
+    unsigned int j = 0;
+
+    for(; j < SIMD_WIDTH; j++)
+        x[j] = sqrt(x[j]);
+
+    return x;
+
+}
+
+#endif
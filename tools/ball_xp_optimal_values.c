@@ -34,12 +34,14 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
 #include <argtable2.h>
 
-#define LIMITED_DEPTH
 #include "../algorithms/optimistic/optimistic.h"
 #include "../problems/ball/ball.h"
 
+#define MAX_DEPTH 512
+
 int main(int argc, char* argv[]) {
 
     double discountFactor = 0.9;
@@ -56,9 +58,10 @@ int main(int argc, char* argv[]) {
     struct arg_int* k = arg_int1("k", NULL, "<n>", "The branching factor of the problem");
     struct arg_int* it = arg_int1("n", NULL, "<n>", "The number of iterations");
     struct arg_file* outputFile = arg_file1("o", NULL, "<file>", "The output file");
-    struct arg_end* end = arg_end(5);
+    struct arg_int* w = arg_int0(NULL, "seed", "<n>", "The seed of the random numbers, the current time if not given");
+    struct arg_end* end = arg_end(6);
 
-    void* argtable[5];
+    void* argtable[6];
 
     int nerrors = 0;
 
@@ -66,11 +69,12 @@ int main(int argc, char* argv[]) {
     argtable[1] = it;
     argtable[2] = outputFile;
     argtable[3] = k;
-    argtable[4] = end;
+    argtable[4] = w;
+    argtable[5] = end;
 
     if(arg_nullcheck(argtable) != 0) {
         printf("error: insufficient memory\n");
-        arg_freetable(argtable, 5);
+        arg_freetable(argtable, 6);
         return EXIT_FAILURE;
     }
 
@@ -80,12 +84,14 @@ int main(int argc, char* argv[]) {
         printf("%s:", argv[0]);
         arg_print_syntax(stdout, argtable, "\n");
         arg_print_errors(stdout, end, argv[0]);
-        arg_freetable(argtable, 5);
+        arg_freetable(argtable, 6);
         return EXIT_FAILURE;
     }
 
     nbIterations = it->ival[0];
 
+    modelSeed = w->count ? (uint64_t)w->ival[0] : (uint64_t)time(NULL);
+
     initGenerativeModelParameters();
     K = k->ival[0];
     initGenerativeModel();
@@ -95,9 +101,10 @@ int main(int argc, char* argv[]) {
     initFileFd = fopen(initFile->filename[0], "r");
     readFscanf = fscanf(initFileFd, "%u\n", &n);
 
-    arg_freetable(argtable, 5);
+    arg_freetable(argtable, 6);
 
     optimistic = optimistic_initInstance(NULL, discountFactor);
+    optimistic_setMaxDepth(optimistic, MAX_DEPTH);
 
     for(; i < n; i++) {
         char str[1024];
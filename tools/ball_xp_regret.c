@@ -39,7 +39,6 @@
 #include <math.h>
 #include <string.h>
 
-#define LIMITED_DEPTH
 #include "../algorithms/optimistic/optimistic.h"
 #include "../algorithms/random_search/random_search.h"
 #include "../algorithms/uct/uct.h"
@@ -47,6 +46,8 @@
 
 #include "../problems/ball/ball.h"
 
+#define MAX_DEPTH 512
+
 int main(int argc, char* argv[]) {
 
     double discountFactor = 0.9;
@@ -73,9 +74,10 @@ int main(int argc, char* argv[]) {
     struct arg_int* k = arg_int1("k", NULL, "<n>", "Branching factor of the problem");
     struct arg_file* where = arg_file1(NULL, "where", "<file>", "Directory where we save the outputs");
     struct arg_file* optimal = arg_file1(NULL, "optimal", "<file>", "File containing the optimal values");
-    struct arg_end* end = arg_end(6);
+    struct arg_int* w = arg_int0(NULL, "seed", "<n>", "The seed of the random numbers, the current time if not given");
+    struct arg_end* end = arg_end(7);
 
-    void* argtable[6];
+    void* argtable[7];
     int nerrors = 0;
 
     argtable[0] = initFile;
@@ -83,11 +85,12 @@ int main(int argc, char* argv[]) {
     argtable[2] = d;
     argtable[3] = k;
     argtable[4] = optimal;
-    argtable[5] = end;
+    argtable[5] = w;
+    argtable[6] = end;
 
     if(arg_nullcheck(argtable) != 0) {
         printf("error: insufficient memory\n");
-        arg_freetable(argtable, 6);
+        arg_freetable(argtable, 7);
         return EXIT_FAILURE;
     }
 
@@ -97,10 +100,12 @@ int main(int argc, char* argv[]) {
         printf("%s:", argv[0]);
         arg_print_syntax(stdout, argtable, "\n");
         arg_print_errors(stdout, end, argv[0]);
-        arg_freetable(argtable, 6);
+        arg_freetable(argtable, 7);
         return EXIT_FAILURE;
     }
 
+    modelSeed = w->count ? (uint64_t)w->ival[0] : (uint64_t)time(NULL);
+
     initGenerativeModelParameters();
     K = k->ival[0];
     initGenerativeModel();
@@ -127,14 +132,19 @@ int main(int argc, char* argv[]) {
         fprintf(combinedFd[i - 1], "n,optimistic,random search,uct,uniform\n");
     }
 
-    arg_freetable(argtable, 6);
+    arg_freetable(argtable, 7);
 
     optimalValues = (double*)malloc(sizeof(double) * K);
 
     optimistic = optimistic_initInstance(initialStates[0], discountFactor);
+    optimistic_setMaxDepth(optimistic, MAX_DEPTH);
     random_search = random_search_initInstance(initialStates[0], discountFactor);
+    random_search_setSeed(random_search, modelSeed);
+    random_search_setMaxDepth(random_search, MAX_DEPTH);
     uct = uct_initInstance(initialStates[0], discountFactor);
+    uct_setMaxDepth(uct, MAX_DEPTH);
     uniform = uniform_initInstance(initialStates[0], discountFactor);
+    uniform_setMaxDepth(uniform, MAX_DEPTH);
 
     for(i = 0; i < n; i++) {
         unsigned int j = 1;
@@ -74,10 +74,11 @@ int main(int argc, char* argv[]) {
     struct arg_int* s = arg_int1("s", NULL, "<n>", "Number of steps");
     struct arg_int* k = arg_int1("k", NULL, "<n>", "Branching factor of the problem");
     struct arg_file* where = arg_file1(NULL, "where", "<file>", "Directory where we save the outputs");
-    struct arg_end* end = arg_end(7);
+    struct arg_int* w = arg_int0(NULL, "seed", "<n>", "The seed of the random numbers, the current time if not given");
+    struct arg_end* end = arg_end(8);
 
     int nerrors = 0;
-    void* argtable[7];
+    void* argtable[8];
 
     argtable[0] = initFile;
     argtable[1] = d2;
@@ -85,11 +86,12 @@ int main(int argc, char* argv[]) {
     argtable[3] = s;
     argtable[4] = k;
     argtable[5] = where;
-    argtable[6] = end;
+    argtable[6] = w;
+    argtable[7] = end;
 
     if(arg_nullcheck(argtable) != 0) {
         printf("error: insufficient memory\n");
-        arg_freetable(argtable, 7);
+        arg_freetable(argtable, 8);
         return EXIT_FAILURE;
     }
 
@@ -99,10 +101,12 @@ int main(int argc, char* argv[]) {
         printf("%s:", argv[0]);
         arg_print_syntax(stdout, argtable, "\n");
         arg_print_errors(stdout, end, argv[0]);
-        arg_freetable(argtable, 7);
+        arg_freetable(argtable, 8);
         return EXIT_FAILURE;
     }
 
+    modelSeed = w->count ? (uint64_t)w->ival[0] : (uint64_t)time(NULL);
+
     initGenerativeModelParameters();
     K = k->ival[0];
     initGenerativeModel();
@@ -125,6 +129,7 @@ int main(int argc, char* argv[]) {
 
     optimistic = optimistic_initInstance(NULL, discountFactor);
     random_search = random_search_initInstance(NULL, discountFactor);
+    random_search_setSeed(random_search, modelSeed);
     uct = uct_initInstance(NULL, discountFactor);
     uniform = uniform_initInstance(NULL, discountFactor);
 
@@ -239,7 +244,7 @@ int main(int argc, char* argv[]) {
 
     fclose(results);
 
-    arg_freetable(argtable, 7);
+    arg_freetable(argtable, 8);
 
     free(setPoints);
 
@@ -0,0 +1,453 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <argtable2.h>
+
+#include "../algorithms/optimistic/optimistic.h"
+#include "../algorithms/random_search/random_search.h"
+#include "../algorithms/uct/uct.h"
+#include "../algorithms/uniform/uniform.h"
+
+/* Runs the four planners on one problem, the problem of the binary, over budgets from a geometric range, with and
+ * without keeping the subtree from a step to the next. Each configuration plans nbSteps steps from each initial state
+ * through the same *_initInstance and *_planning as the xp tools. A line of CSV is written for it. It is run in a process
+ * of its own so that its peak resident memory is its own. */
+
+#define NB_PLANNERS 4
+
+static const char* plannerNames[NB_PLANNERS] = {"optimistic", "random_search", "uct", "uniform"};
+
+typedef struct {
+    unsigned int planner;               // Index in plannerNames
+    optimistic_instance* optimistic;
+    random_search_instance* randomSearch;
+    uct_instance* uct;
+    uniform_instance* uniform;
+}   bench_instance;
+
+
+static void initInstance(bench_instance* instance, unsigned int planner, double discountFactor) {
+
+    memset(instance, 0, sizeof(bench_instance));
+    instance->planner = planner;
+
+    switch(planner) {
+        case 0: instance->optimistic = optimistic_initInstance(NULL, discountFactor); break;
+        case 1: instance->randomSearch = random_search_initInstance(NULL, discountFactor);
+                random_search_setSeed(instance->randomSearch, modelSeed); break;
+        case 2: instance->uct = uct_initInstance(NULL, discountFactor); break;
+        default: instance->uniform = uniform_initInstance(NULL, discountFactor); break;
+    }
+
+}
+
+
+/* Returns 0 if the planner does not keep anything from a step to the next. */
+static char canKeepSubtree(unsigned int planner) {
+
+    return planner != 1;
+
+}
+
+
+static void resetInstance(bench_instance* instance, state* s) {
+
+    switch(instance->planner) {
+        case 0: optimistic_resetInstance(instance->optimistic, s); break;
+        case 1: random_search_resetInstance(instance->randomSearch, s); break;
+        case 2: uct_resetInstance(instance->uct, s); break;
+        default: uniform_resetInstance(instance->uniform, s); break;
+    }
+
+}
+
+
+static void keepSubtree(bench_instance* instance) {
+
+    switch(instance->planner) {
+        case 0: optimistic_keepSubtree(instance->optimistic); break;
+        case 2: uct_keepSubtree(instance->uct); break;
+        case 3: uniform_keepSubtree(instance->uniform); break;
+    }
+
+}
+
+
+static action* planning(bench_instance* instance, unsigned int maxNbEvaluations) {
+
+    switch(instance->planner) {
+        case 0: return optimistic_planning(instance->optimistic, maxNbEvaluations);
+        case 1: return random_search_planning(instance->randomSearch, maxNbEvaluations);
+        case 2: return uct_planning(instance->uct, maxNbEvaluations);
+        default: return uniform_planning(instance->uniform, maxNbEvaluations);
+    }
+
+}
+
+
+/* Returns the number of evaluations done by the last planning. */
+static unsigned int getNbEvaluations(bench_instance* instance) {
+
+    switch(instance->planner) {
+        case 0: return instance->optimistic->realNbEvaluations;
+        case 1: return instance->randomSearch->realNbEvaluations;
+        case 2: return instance->uct->realNbEvaluations;
+        default: return instance->uniform->realNbEvaluations;
+    }
+
+}
+
+
+/* Returns the number of nodes the planner stores, 0 for the random search which only keeps discounted sums. */
+static unsigned int getNbNodes(bench_instance* instance) {
+
+    switch(instance->planner) {
+        case 0: return instance->optimistic->root->nbNodes + 1;
+        case 1: return 0;
+        case 2: return instance->uct->root->n;
+        default: return instance->uniform->crtNbEvaluations + 1;
+    }
+
+}
+
+
+static unsigned int getMaxDepth(bench_instance* instance) {
+
+    switch(instance->planner) {
+        case 0: return optimistic_getMaxDepth(instance->optimistic);
+        case 1: return random_search_getMaxDepth(instance->randomSearch);
+        case 2: return uct_getMaxDepth(instance->uct);
+        default: return uniform_getMaxDepth(instance->uniform);
+    }
+
+}
+
+
+static void uninitInstance(bench_instance* instance) {
+
+    switch(instance->planner) {
+        case 0: optimistic_uninitInstance(&instance->optimistic); break;
+        case 1: random_search_uninitInstance(&instance->randomSearch); break;
+        case 2: uct_uninitInstance(&instance->uct); break;
+        default: uniform_uninitInstance(&instance->uniform); break;
+    }
+
+}
+
+
+/* Returns the peak resident memory of the process in kilobytes. */
+static unsigned long getPeakRss() {
+
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return (unsigned long)usage.ru_maxrss;
+
+}
+
+
+static int compareTimes(const void* a, const void* b) {
+
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+
+    return x < y ? -1 : (x > y ? 1 : 0);
+
+}
+
+
+/* Returns the nearest rank percentile of the nbTimes sorted times, in microseconds. */
+static double getPercentile(uint64_t* times, unsigned int nbTimes, unsigned int percent) {
+
+    unsigned int rank = ((nbTimes * percent) + 99) / 100;
+
+    return times[rank > 0 ? rank - 1 : 0] * 1e-3;
+
+}
+
+
+/* The time of a step is the one of the planning and of the reset or keepSubtree before it. */
+static void runConfiguration(FILE* file, unsigned int planner, unsigned int maxNbEvaluations, char isSubtreeKept, state** initialStates, unsigned int nbInitialStates, unsigned int nbSteps, double discountFactor) {
+
+    uint64_t* times = (uint64_t*)malloc(sizeof(uint64_t) * nbInitialStates * nbSteps);
+    unsigned long baseRss = getPeakRss();
+    unsigned long peakRss = 0;
+    uint64_t totalTime = 0;
+    uint64_t nbEvaluations = 0;
+    unsigned int nbTimes = 0;
+    unsigned int maxNbNodes = 0;
+    unsigned int maxDepth = 0;
+    bench_instance instance;
+    unsigned int i = 0;
+
+    initInstance(&instance, planner, discountFactor);
+
+    for(; i < nbInitialStates; i++) {
+        state* crt = copyState(initialStates[i]);
+        unsigned int j = 0;
+
+        resetInstance(&instance, crt);
+
+        for(; j < nbSteps; j++) {
+            uint64_t start = deadline_now();
+            state* nextState = NULL;
+            double reward = 0.0;
+            char isTerminal = 0;
+            action* optimalAction = NULL;
+
+            if(isSubtreeKept && (j > 0))
+                keepSubtree(&instance);
+            else
+                resetInstance(&instance, crt);
+            optimalAction = planning(&instance, maxNbEvaluations);
+            times[nbTimes] = deadline_now() - start;
+            totalTime += times[nbTimes++];
+
+            nbEvaluations += getNbEvaluations(&instance);
+            if(getNbNodes(&instance) > maxNbNodes)
+                maxNbNodes = getNbNodes(&instance);
+            if(getMaxDepth(&instance) > maxDepth)
+                maxDepth = getMaxDepth(&instance);
+
+            isTerminal = nextStateReward(crt, optimalAction, &nextState, &reward);
+            freeState(crt);
+            crt = nextState;
+
+            if(isTerminal < 0)
+                break;
+        }
+
+        freeState(crt);
+    }
+
+    peakRss = getPeakRss();
+    qsort(times, nbTimes, sizeof(uint64_t), compareTimes);
+
+    fprintf(file, "%s,%s,%u,%d,%u,%.0f,%lu,%.1f,%u,%u,%.1f,%.1f,%.1f,%.1f\n", plannerNames[planner], PROBLEM_NAME, maxNbEvaluations, isSubtreeKept, nbTimes,
+            totalTime > 0 ? nbEvaluations / (totalTime * 1e-9) : 0.0, peakRss, maxNbNodes > 0 ? ((peakRss - baseRss) * 1024.0) / maxNbNodes : 0.0, maxNbNodes, maxDepth,
+            getPercentile(times, nbTimes, 50), getPercentile(times, nbTimes, 90), getPercentile(times, nbTimes, 99), times[nbTimes - 1] * 1e-3);
+
+    uninitInstance(&instance);
+    free(times);
+
+}
+
+
+/* Reads the states of a file written by problems_xp_initial_states. Returns NULL if it can not. */
+static state** readStates(const char* fileName, unsigned int* nbStates) {
+
+    FILE* file = fopen(fileName, "r");
+    state** states = NULL;
+    char str[1024];
+    unsigned int i = 0;
+
+    if((file == NULL) || (fscanf(file, "%u\n", nbStates) != 1) || (*nbStates == 0)) {
+        if(file != NULL)
+            fclose(file);
+        return NULL;
+    }
+
+    states = (state**)malloc(sizeof(state*) * *nbStates);
+
+    for(; i < *nbStates; i++) {
+        if(fscanf(file, "%1023s\n", str) != 1)
+            break;
+        states[i] = makeState(str);
+    }
+
+    *nbStates = i;
+    fclose(file);
+
+    return states;
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+    double discountFactor = 0.95;
+    unsigned int minNbEvaluations = 100;
+    unsigned int maxNbEvaluations = 100000;
+    unsigned int factor = 10;
+    unsigned int nbSteps = 10;
+    state** initialStates = NULL;
+    unsigned int nbInitialStates = 1;
+    FILE* outputFd = stdout;
+    unsigned int planner = 0;
+    unsigned int i = 0;
+
+    struct arg_dbl* g = arg_dbl0("g", "discountFactor", "<d>", "The discount factor for the problem, 0.95 if not given");
+    struct arg_int* n = arg_int0(NULL, "min", "<n>", "The smallest budget in evaluations, 100 if not given");
+    struct arg_int* x = arg_int0(NULL, "max", "<n>", "The largest budget in evaluations, 100000 if not given");
+    struct arg_int* f = arg_int0(NULL, "factor", "<n>", "The factor from a budget to the next, 10 if not given");
+    struct arg_int* s = arg_int0("s", NULL, "<n>", "The number of steps planned from each initial state, 10 if not given");
+    struct arg_file* initFile = arg_file0(NULL, "init", "<file>", "File of initial states written by problems_xp_initial_states, the initial state of the problem if not given");
+    struct arg_int* b = arg_int0("b", "branchingFactor", "<n>", "The branching factor of the problem");
+    struct arg_file* o = arg_file0("o", NULL, "<file>", "The CSV file the results are written to, the standard output if not given");
+    struct arg_int* w = arg_int0(NULL, "seed", "<n>", "The seed of the random numbers, the current time if not given");
+    struct arg_end* end = arg_end(10);
+
+    int nerrors = 0;
+    void* argtable[10];
+
+    argtable[0] = g;
+    argtable[1] = n;
+    argtable[2] = x;
+    argtable[3] = f;
+    argtable[4] = s;
+    argtable[5] = initFile;
+    argtable[6] = b;
+    argtable[7] = o;
+    argtable[8] = w;
+    argtable[9] = end;
+
+    if(arg_nullcheck(argtable) != 0) {
+        printf("error: insufficient memory\n");
+        arg_freetable(argtable, 10);
+        return EXIT_FAILURE;
+    }
+
+    nerrors = arg_parse(argc, argv, argtable);
+
+    if(nerrors > 0) {
+        printf("%s:", argv[0]);
+        arg_print_syntax(stdout, argtable, "\n");
+        arg_print_errors(stdout, end, argv[0]);
+        arg_freetable(argtable, 10);
+        return EXIT_FAILURE;
+    }
+
+    if(g->count)
+        discountFactor = g->dval[0];
+    if(n->count)
+        minNbEvaluations = n->ival[0];
+    if(x->count)
+        maxNbEvaluations = x->ival[0];
+    if(f->count)
+        factor = f->ival[0];
+    if(s->count)
+        nbSteps = s->ival[0];
+
+    if((minNbEvaluations == 0) || (factor < 2) || (nbSteps == 0)) {
+        printf("error: the budgets and the number of steps must be positive, and the factor at least 2\n");
+        arg_freetable(argtable, 10);
+        return EXIT_FAILURE;
+    }
+
+    modelSeed = w->count ? (uint64_t)w->ival[0] : (uint64_t)time(NULL);
+
+    initGenerativeModelParameters();
+    if(b->count)
+        K = b->ival[0];
+    initGenerativeModel();
+
+    if(initFile->count) {
+        initialStates = readStates(initFile->filename[0], &nbInitialStates);
+        if((initialStates == NULL) || (nbInitialStates == 0)) {
+            printf("error: can not read the states of %s\n", initFile->filename[0]);
+            arg_freetable(argtable, 10);
+            return EXIT_FAILURE;
+        }
+    } else {
+        initialStates = (state**)malloc(sizeof(state*));
+        initialStates[0] = initState();
+    }
+
+    if(o->count) {
+        outputFd = fopen(o->filename[0], "w");
+        if(outputFd == NULL) {
+            printf("error: can not open %s\n", o->filename[0]);
+            arg_freetable(argtable, 10);
+            return EXIT_FAILURE;
+        }
+    }
+
+    arg_freetable(argtable, 10);
+
+    fprintf(outputFd, "planner,problem,budget,keepSubtree,nbSteps,evaluationsPerSecond,peakRss,bytesPerNode,maxNbNodes,maxDepth,latencyP50,latencyP90,latencyP99,latencyMax\n");
+
+    for(; planner < NB_PLANNERS; planner++) {
+        unsigned int budget = minNbEvaluations;
+
+        while(budget <= maxNbEvaluations) {
+            char isSubtreeKept = 0;
+
+            for(; isSubtreeKept <= canKeepSubtree(planner); isSubtreeKept++) {
+                pid_t pid = 0;
+
+                fflush(outputFd);                                                           // Else what is buffered would be written by both processes
+                pid = fork();
+
+                if(pid == 0) {
+                    runConfiguration(outputFd, planner, budget, isSubtreeKept, initialStates, nbInitialStates, nbSteps, discountFactor);
+                    fclose(outputFd);
+                    _exit(EXIT_SUCCESS);
+                }
+
+                if(pid < 0)
+                    runConfiguration(outputFd, planner, budget, isSubtreeKept, initialStates, nbInitialStates, nbSteps, discountFactor);
+                else
+                    waitpid(pid, NULL, 0);
+            }
+
+            if(budget > (maxNbEvaluations / factor))
+                break;
+            budget *= factor;
+        }
+    }
+
+    if(outputFd != stdout)
+        fclose(outputFd);
+
+    for(; i < nbInitialStates; i++)
+        freeState(initialStates[i]);
+    free(initialStates);
+
+    freeGenerativeModel();
+    freeGenerativeModelParameters();
+
+    return EXIT_SUCCESS;
+
+}
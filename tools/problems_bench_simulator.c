@@ -0,0 +1,331 @@
+/* Copyright or © or Copr. 2012, Jean-François Hren
+ *
+ * Author e-mail: jean-francois.hren@inria.fr
+ *
+ * This software is a computer program whose purpose is to control
+ * deterministic systems using optimistic planning.
+ *
+ * This software is governed by the CeCILL license under French law and
+ * abiding by the rules of distribution of free software.  You can  use, 
+ * modify and/ or redistribute the software under the terms of the CeCILL
+ * license as circulated by CEA, CNRS and INRIA at the following URL
+ * "http://www.cecill.info". 
+ *
+ * As a counterpart to the access to the source code and  rights to copy,
+ * modify and redistribute granted by the license, users are provided only
+ * with a limited warranty  and the software's author,  the holder of the
+ * economic rights,  and the successive licensors  have only  limited
+ * liability. 
+ *
+ * In this respect, the user's attention is drawn to the risks associated
+ * with loading,  using,  modifying and/or developing or reproducing the
+ * software by the user in light of its specific status of free software,
+ * that may mean  that it is complicated to manipulate,  and  that  also
+ * therefore means  that it is reserved for developers  and  experienced
+ * professionals having in-depth computer knowledge. Users are therefore
+ * encouraged to load and test the software's suitability as regards their
+ * requirements in conditions enabling the security of their systems and/or 
+ * data to be ensured and,  more generally, to use and operate it in the 
+ * same conditions as regards security. 
+ *
+ * The fact that you are presently reading this means that you have had
+ * knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <argtable2.h>
+
+#include "../problems/generative_model.h"
+#include "../problems/rng.h"
+#include "../algorithms/deadline/deadline.h"
+
+/* Times the calls to the generative model a planner makes, one problem per binary. The calls are made from a set of
+ * states in turn, with the actions in turn: the states of a file written by problems_xp_initial_states, or else the
+ * states met by random actions from the initial state. A line of CSV is written per operation. */
+
+static volatile double sink = 0.0;                                                          // Where the results go so that the calls are not optimized away
+
+
+static void writeResult(FILE* file, const char* operation, unsigned int nbCalls, uint64_t time) {
+
+    fprintf(file, "%s,%u,%s,%u,%lu,%.3f,%.0f\n", PROBLEM_NAME, K, operation, nbCalls, (unsigned long)time, time / (double)nbCalls, nbCalls / (time * 1e-9));
+
+}
+
+
+/* Reads the states of a file of problems_xp_initial_states, along with their strings for makeState. */
+static state** readStates(const char* fileName, unsigned int* nbStates, char*** strs) {
+
+    FILE* file = fopen(fileName, "r");
+    state** states = NULL;
+    char str[1024];
+    unsigned int i = 0;
+
+    if((file == NULL) || (fscanf(file, "%u\n", nbStates) != 1) || (*nbStates == 0)) {
+        if(file != NULL)
+            fclose(file);
+        return NULL;
+    }
+
+    states = (state**)malloc(sizeof(state*) * *nbStates);
+    *strs = (char**)malloc(sizeof(char*) * *nbStates);
+
+    for(; i < *nbStates; i++) {
+        if(fscanf(file, "%1023s\n", str) != 1)
+            break;
+        (*strs)[i] = (char*)malloc(strlen(str) + 1);
+        strcpy((*strs)[i], str);
+        states[i] = makeState(str);
+    }
+
+    *nbStates = i;
+    fclose(file);
+
+    return states;
+
+}
+
+
+/* Returns the nbStates states met by random actions from the initial state, which is started from again at each
+ * terminal state. */
+static state** makeTrajectoryStates(unsigned int nbStates, rng_stream* rng) {
+
+    state** states = (state**)malloc(sizeof(state*) * nbStates);
+    state* crt = initState();
+    unsigned int i = 0;
+
+    for(; i < nbStates; i++) {
+        double reward = 0.0;
+        state* next = NULL;
+        char isTerminal = nextStateReward(crt, actions[rng_uniformInt(rng, K)], &next, &reward);
+
+        states[i] = crt;
+        crt = isTerminal < 0 ? initState() : next;
+        if(isTerminal < 0)
+            freeState(next);
+    }
+
+    freeState(crt);
+
+    return states;
+
+}
+
+
+/* The state returned is freed in the loop, so that the time of freeState is counted as well. */
+static uint64_t benchNextStateReward(state** states, unsigned int nbStates, unsigned int nbCalls) {
+
+    uint64_t start = deadline_now();
+    unsigned int i = 0;
+
+    for(; i < nbCalls; i++) {
+        double reward = 0.0;
+        state* next = NULL;
+
+        nextStateReward(states[i % nbStates], actions[i % K], &next, &reward);
+        sink += reward;
+        freeState(next);
+    }
+
+    return deadline_now() - start;
+
+}
+
+
+static uint64_t benchNextStateRewardInto(state** states, unsigned int nbStates, unsigned int nbCalls) {
+
+    state* next = (state*)malloc(getStateSize());
+    uint64_t start = deadline_now();
+    unsigned int i = 0;
+
+    for(; i < nbCalls; i++) {
+        double reward = 0.0;
+
+        nextStateRewardInto(states[i % nbStates], actions[i % K], next, &reward);
+        sink += reward;
+    }
+
+    start = deadline_now() - start;
+    free(next);
+
+    return start;
+
+}
+
+
+/* Each call simulates the K children of a state. */
+static uint64_t benchNextStatesRewardsInto(state** states, unsigned int nbStates, unsigned int nbCalls) {
+
+    state* nextStates = (state*)malloc(getStateSize() * K);
+    double* rewards = (double*)malloc(sizeof(double) * K);
+    char* results = (char*)malloc(sizeof(char) * K);
+    uint64_t start = deadline_now();
+    unsigned int i = 0;
+
+    for(; i < nbCalls; i++) {
+        nextStatesRewardsInto(states[i % nbStates], nextStates, rewards, results);
+        sink += rewards[0];
+    }
+
+    start = deadline_now() - start;
+    free(nextStates);
+    free(rewards);
+    free(results);
+
+    return start;
+
+}
+
+
+/* A call is a copy and the free of the copy. */
+static uint64_t benchCopyState(state** states, unsigned int nbStates, unsigned int nbCalls) {
+
+    uint64_t start = deadline_now();
+    unsigned int i = 0;
+
+    for(; i < nbCalls; i++)
+        freeState(copyState(states[i % nbStates]));
+
+    return deadline_now() - start;
+
+}
+
+
+/* A call is the parsing of a state and its free. */
+static uint64_t benchMakeState(char** strs, unsigned int nbStates, unsigned int nbCalls) {
+
+    uint64_t start = deadline_now();
+    unsigned int i = 0;
+
+    for(; i < nbCalls; i++)
+        freeState(makeState(strs[i % nbStates]));
+
+    return deadline_now() - start;
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+    unsigned int nbCalls = 0;
+    unsigned int nbWarmupCalls = 0;
+    unsigned int nbStates = 0;
+    state** states = NULL;
+    char** strs = NULL;
+    FILE* outputFd = stdout;
+    rng_stream rng;
+    unsigned int i = 0;
+
+    struct arg_int* n = arg_int0("n", NULL, "<n>", "The number of calls timed per operation, 100000 if not given");
+    struct arg_file* initFile = arg_file0(NULL, "init", "<file>", "File of states written by problems_xp_initial_states, the states met by random actions if not given");
+    struct arg_int* m = arg_int0(NULL, "states", "<n>", "The number of states met by random actions the calls are made from, 1000 if not given");
+    struct arg_int* b = arg_int0("b", "branchingFactor", "<n>", "The branching factor of the problem");
+    struct arg_file* o = arg_file0("o", NULL, "<file>", "The CSV file the results are written to, the standard output if not given");
+    struct arg_int* w = arg_int0(NULL, "seed", "<n>", "The seed of the random numbers, the current time if not given");
+    struct arg_end* end = arg_end(7);
+
+    int nerrors = 0;
+    void* argtable[7];
+
+    argtable[0] = n;
+    argtable[1] = initFile;
+    argtable[2] = m;
+    argtable[3] = b;
+    argtable[4] = o;
+    argtable[5] = w;
+    argtable[6] = end;
+
+    if(arg_nullcheck(argtable) != 0) {
+        printf("error: insufficient memory\n");
+        arg_freetable(argtable, 7);
+        return EXIT_FAILURE;
+    }
+
+    nerrors = arg_parse(argc, argv, argtable);
+
+    if(nerrors > 0) {
+        printf("%s:", argv[0]);
+        arg_print_syntax(stdout, argtable, "\n");
+        arg_print_errors(stdout, end, argv[0]);
+        arg_freetable(argtable, 7);
+        return EXIT_FAILURE;
+    }
+
+    nbCalls = n->count ? n->ival[0] : 100000;
+    nbWarmupCalls = nbCalls / 10;
+    modelSeed = w->count ? (uint64_t)w->ival[0] : (uint64_t)time(NULL);
+
+    initGenerativeModelParameters();
+    if(b->count)
+        K = b->ival[0];
+    initGenerativeModel();
+
+    rng_initStream(&rng, modelSeed, RNG_STREAM(RNG_TOOLS, 1, 0));
+
+    if(initFile->count) {
+        states = readStates(initFile->filename[0], &nbStates, &strs);
+        if(states == NULL) {
+            printf("error: can not read the states of %s\n", initFile->filename[0]);
+            arg_freetable(argtable, 7);
+            return EXIT_FAILURE;
+        }
+    } else {
+        nbStates = m->count ? m->ival[0] : 1000;
+        if(nbStates == 0) {
+            printf("error: the calls need at least one state\n");
+            arg_freetable(argtable, 7);
+            return EXIT_FAILURE;
+        }
+        states = makeTrajectoryStates(nbStates, &rng);
+    }
+
+    if(o->count) {
+        outputFd = fopen(o->filename[0], "w");
+        if(outputFd == NULL) {
+            printf("error: can not open %s\n", o->filename[0]);
+            arg_freetable(argtable, 7);
+            return EXIT_FAILURE;
+        }
+    }
+
+    arg_freetable(argtable, 7);
+
+    fprintf(outputFd, "problem,K,operation,nbCalls,time,nsPerCall,callsPerSecond\n");
+
+    benchNextStateReward(states, nbStates, nbWarmupCalls);
+    writeResult(outputFd, "nextStateReward", nbCalls, benchNextStateReward(states, nbStates, nbCalls));
+
+    benchNextStateRewardInto(states, nbStates, nbWarmupCalls);
+    writeResult(outputFd, "nextStateRewardInto", nbCalls, benchNextStateRewardInto(states, nbStates, nbCalls));
+
+    benchNextStatesRewardsInto(states, nbStates, nbWarmupCalls);
+    writeResult(outputFd, "nextStatesRewardsInto", nbCalls, benchNextStatesRewardsInto(states, nbStates, nbCalls));
+
+    benchCopyState(states, nbStates, nbWarmupCalls);
+    writeResult(outputFd, "copyState+freeState", nbCalls, benchCopyState(states, nbStates, nbCalls));
+
+    if(strs != NULL) {                                                                      // Only states read from a file have a string
+        benchMakeState(strs, nbStates, nbWarmupCalls);
+        writeResult(outputFd, "makeState+freeState", nbCalls, benchMakeState(strs, nbStates, nbCalls));
+    }
+
+    if(outputFd != stdout)
+        fclose(outputFd);
+
+    for(; i < nbStates; i++) {
+        freeState(states[i]);
+        if(strs != NULL)
+            free(strs[i]);
+    }
+    free(states);
+    free(strs);
+
+    freeGenerativeModel();
+    freeGenerativeModelParameters();
+
+    return EXIT_SUCCESS;
+
+}
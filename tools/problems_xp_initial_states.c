@@ -35,11 +35,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <argtable2.h>
-#include <gsl/gsl_rng.h>
 #include <time.h>
 #include <string.h>
 #include <math.h>
 
+#include "../problems/rng.h"
+
 
 double* parseIntervals(const char* str, unsigned int* nbIntervals) {
 
@@ -84,26 +85,28 @@ int main(int argc, char* argv[]) {
     unsigned int nbIntervals = 0;
     double* intervals = NULL;
     FILE* outputFileFd = NULL;
-    gsl_rng* rng = NULL;
+    rng_stream rng;
     unsigned int nbStates = 0;
 
     struct arg_file* outputFile = arg_file1("o", NULL, "<file>", "The output file for the generated initial state");
     struct arg_int* n = arg_int1("n", NULL, "<n>", "The number of initial states to generate");
     struct arg_str* s = arg_str1(NULL, "intervals", "<s>", "The intervals for the initial states generation");
-    struct arg_end* end = arg_end(4);
+    struct arg_int* w = arg_int0(NULL, "seed", "<n>", "The seed of the random numbers, the current time if not given");
+    struct arg_end* end = arg_end(5);
 
-    void* argtable[4];
+    void* argtable[5];
 
     int nerrors = 0;
 
     argtable[0] = outputFile;
     argtable[1] = n;
     argtable[2] = s;
-    argtable[3] = end;
+    argtable[3] = w;
+    argtable[4] = end;
 
     if(arg_nullcheck(argtable) != 0) {
         printf("error: insufficient memory\n");
-        arg_freetable(argtable, 4);
+        arg_freetable(argtable, 5);
         return EXIT_FAILURE;
     }
 
@@ -113,7 +116,7 @@ int main(int argc, char* argv[]) {
         printf("%s:", argv[0]);
         arg_print_syntax(stdout, argtable, "\n");
         arg_print_errors(stdout, end, argv[0]);
-        arg_freetable(argtable, 4);
+        arg_freetable(argtable, 5);
         return EXIT_FAILURE;
     }
 
@@ -121,8 +124,7 @@ int main(int argc, char* argv[]) {
 
     intervals = parseIntervals(s->sval[0], &nbIntervals);
 
-    rng = gsl_rng_alloc(gsl_rng_mt19937);
-    gsl_rng_set(rng, time(NULL));
+    rng_initStream(&rng, w->count ? (uint64_t)w->ival[0] : (uint64_t)time(NULL), RNG_STREAM(RNG_TOOLS, 0, 0));
 
     outputFileFd = fopen(outputFile->filename[0], "w");
     fprintf(outputFileFd, "%u\n", n->ival[0]);
@@ -130,14 +132,13 @@ int main(int argc, char* argv[]) {
     for(; i < nbStates; i++) {
         unsigned int j = 0;
         for(; j < (nbIntervals - 1); j++)
-            fprintf(outputFileFd, "%.15f,", (fabs(intervals[(j * 2) + 1] - intervals[j * 2]) * gsl_rng_uniform(rng)) + intervals[j * 2]);
-        fprintf(outputFileFd, "%.15f\n", (fabs(intervals[(j * 2) + 1] - intervals[j * 2]) * gsl_rng_uniform(rng)) + intervals[j * 2]);
+            fprintf(outputFileFd, "%.15f,", (fabs(intervals[(j * 2) + 1] - intervals[j * 2]) * rng_uniform(&rng)) + intervals[j * 2]);
+        fprintf(outputFileFd, "%.15f\n", (fabs(intervals[(j * 2) + 1] - intervals[j * 2]) * rng_uniform(&rng)) + intervals[j * 2]);
     }
 
     fclose(outputFileFd);
-	gsl_rng_free(rng);
     free(intervals);
-    arg_freetable(argtable, 4);
+    arg_freetable(argtable, 5);
 
     return EXIT_SUCCESS;
 
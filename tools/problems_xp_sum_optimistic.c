@@ -159,21 +159,23 @@ int main(int argc, char* argv[]) {
     struct arg_int* s = arg_int1("s", NULL, "<n>", "Number of steps");
     struct arg_int* k = arg_int1("k", NULL, "<n>", "Branching factor of the problem");
     struct arg_file* where = arg_file1(NULL, "where", "<file>", "Directory where we save the outputs");
-    struct arg_end* end = arg_end(6);
+    struct arg_int* w = arg_int0(NULL, "seed", "<n>", "The seed of the random numbers, the current time if not given");
+    struct arg_end* end = arg_end(7);
 
     int nerrors = 0;
-    void* argtable[6];
+    void* argtable[7];
 
     argtable[0] = initFile;
     argtable[1] = r;
     argtable[2] = s;
     argtable[3] = k;
     argtable[4] = where;
-    argtable[5] = end;
+    argtable[5] = w;
+    argtable[6] = end;
 
     if(arg_nullcheck(argtable) != 0) {
         printf("error: insufficient memory\n");
-        arg_freetable(argtable, 6);
+        arg_freetable(argtable, 7);
         return EXIT_FAILURE;
     }
 
@@ -183,10 +185,12 @@ int main(int argc, char* argv[]) {
         printf("%s:", argv[0]);
         arg_print_syntax(stdout, argtable, "\n");
         arg_print_errors(stdout, end, argv[0]);
-        arg_freetable(argtable, 6);
+        arg_freetable(argtable, 7);
         return EXIT_FAILURE;
     }
 
+    modelSeed = w->count ? (uint64_t)w->ival[0] : (uint64_t)time(NULL);
+
     initGenerativeModelParameters();
     K = k->ival[0];
     initGenerativeModel();
@@ -245,7 +249,7 @@ int main(int argc, char* argv[]) {
 
     fclose(results);
 
-    arg_freetable(argtable, 6);
+    arg_freetable(argtable, 7);
 
     for(i = 0; i < n; i++)
         freeState(initialStates[i]);